@@ -5,6 +5,9 @@
 #include <chrono>
 #include <limits>
 #include <queue>
+#include <random>
+#include <set>
+#include <cassert>
 
 #include "BinaryHeap.h"
 #include "FibonacciHeap.h"
@@ -79,6 +82,7 @@ void dijkstraWithFibonacciHeap(Node *start) {
     }
 
     FibonacciHeap<std::pair<int, Node *>> heap;
+    heap.getPool()->reserve(nodes.size());
     start->dist = 0;
 
     for (auto &node : nodes) {
@@ -94,12 +98,84 @@ void dijkstraWithFibonacciHeap(Node *start) {
             if (e->to->dist > v->dist + e->w) {
                 e->to->dist = v->dist + e->w;
                 e->to->previousNode = v;
-                e->to->nodeInFibonacciHeap.decreaseKey(std::make_pair(e->to->dist, e->to));
+                heap.decreaseKey(e->to->nodeInFibonacciHeap, std::make_pair(e->to->dist, e->to));
             }
         }
     }
 }
 
+// Random pushes, pops, key changes, erases and melds on three heaps, checked against std::set. The first two share a
+// pool and the third has its own, so melds run both the O(1) splice and the copy across pools.
+void checkFibonacciHeap() {
+    typedef FibonacciHeap<std::pair<int, int>> Heap;
+    const int HEAPS = 3, OPERATIONS = 1000000, MELD_INTERVAL = 50000;
+
+    std::mt19937 rng(0);
+    std::shared_ptr<Heap::Pool> shared = std::make_shared<Heap::Pool>();
+    Heap heaps[HEAPS] = {Heap(shared), Heap(shared), Heap(std::make_shared<Heap::Pool>())};
+    std::set<std::pair<int, int>> expected[HEAPS];
+
+    // Melds done in turn, as {to, from}
+    const int MELDS[][2] = {{0, 1}, {0, 2}, {2, 0}};
+
+    // The key and heap of every pushed element, heap -1 once it's removed and -2 once its handle is invalid because it
+    // was copied to another pool, it's still checked as part of the heap's minimum then
+    std::vector<Heap::NodeProxy> handles;
+    std::vector<std::pair<int, int>> keys;
+    std::vector<int> owner;
+
+    for (int i = 0; i < OPERATIONS; i++) {
+        int h = rng() % HEAPS, op = rng() % 10;
+        if (op < 4) {
+            std::pair<int, int> key(rng() % 1000000, keys.size());
+            handles.push_back(heaps[h].push(key));
+            keys.push_back(key);
+            owner.push_back(h);
+            expected[h].insert(key);
+        } else if (op < 6) {
+            if (expected[h].empty()) continue;
+            assert(heaps[h].getMin().getKey() == *expected[h].begin());
+            owner[expected[h].begin()->second] = -1;
+            expected[h].erase(expected[h].begin());
+            heaps[h].deleteMin();
+        } else {
+            if (keys.empty()) continue;
+            int x = rng() % keys.size();
+            if (owner[x] < 0) continue;
+
+            Heap &heap = heaps[owner[x]];
+            std::set<std::pair<int, int>> &set = expected[owner[x]];
+            set.erase(keys[x]);
+            if (op < 8) {
+                keys[x].first -= rng() % 1000 + 1;
+                heap.decreaseKey(handles[x], keys[x]);
+                set.insert(keys[x]);
+            } else if (op < 9) {
+                keys[x].first += rng() % 1000;
+                heap.increaseKey(handles[x], keys[x]);
+                set.insert(keys[x]);
+            } else {
+                heap.erase(handles[x]);
+                owner[x] = -1;
+            }
+        }
+
+        if (i % MELD_INTERVAL == MELD_INTERVAL - 1) {
+            auto [to, from] = MELDS[i / MELD_INTERVAL % 3];
+            bool samePool = heaps[to].getPool() == heaps[from].getPool();
+            heaps[to].meld(std::move(heaps[from]));
+            expected[to].insert(expected[from].begin(), expected[from].end());
+            expected[from].clear();
+            for (int &o : owner) if (o == from) o = samePool ? to : -2;
+        }
+
+        for (int j = 0; j < HEAPS; j++) {
+            assert(heaps[j].size() == expected[j].size());
+            assert(expected[j].empty() || heaps[j].getMin().getKey() == *expected[j].begin());
+        }
+    }
+}
+
 void measureTime(std::string actionName, std::function<void ()> function) {
     auto startTime = std::chrono::high_resolution_clock::now();
 
@@ -111,6 +187,8 @@ void measureTime(std::string actionName, std::function<void ()> function) {
 }
 
 int main() {
+    measureTime("Check Fibonacci Heap operations", checkFibonacciHeap);
+
     std::ifstream fin("./graph.txt");
     std::ofstream fout("./ans.out");
 
@@ -1,33 +1,72 @@
 #ifndef _MENCI_FIBONACCIHEAP_H
 #define _MENCI_FIBONACCIHEAP_H
 
-#include <list>
 #include <vector>
+#include <algorithm>
 #include <memory>
 #include <utility>
 #include <stdexcept>
 #include <cassert>
+#include <cstdint>
+#include <type_traits>
 
 template <typename TKey,
           typename Compare = std::less<TKey>>
 class FibonacciHeap {
-    class Node {
-        friend class FibonacciHeap;
+    static constexpr uint32_t NIL = UINT32_MAX;
 
+    // Siblings form a circular doubly linked list through left and right, the root list is the siblings of minNode
+    struct Node {
         TKey key;
-        std::weak_ptr<Node> parent;
-        bool marked = false;
-        std::list<std::shared_ptr<Node>> childList;
+        uint32_t parent, child, left, right, degree;
+        bool marked;
 
-        typename std::list<std::shared_ptr<Node>>::iterator iterator;
+        template <typename T>
+        Node(T &&key, uint32_t self) : key(std::forward<T>(key)), parent(NIL), child(NIL), left(self), right(self), degree(0), marked(false) {}
+    };
+
+public:
+    // Nodes of one or more heaps, referred to by index. Freed nodes are chained through right and reused first. A freed
+    // node's key is reset to TKey() at once, so keys with a non-trivial destructor must be default constructible.
+    class Pool {
+        friend FibonacciHeap;
+
+        std::vector<Node> nodes;
+        uint32_t freeList = NIL;
 
         template <typename T>
-        Node(T &&key, std::shared_ptr<Node> parent = nullptr) : key(key), parent(parent) {}
+        uint32_t allocate(T &&key) {
+            if (freeList != NIL) {
+                uint32_t v = freeList;
+                freeList = nodes[v].right;
+                nodes[v] = Node(std::forward<T>(key), v);
+                return v;
+            }
+
+            if (nodes.size() >= NIL) throw std::length_error("too many nodes");
+            nodes.emplace_back(std::forward<T>(key), nodes.size());
+            return nodes.size() - 1;
+        }
+
+        void deallocate(uint32_t v) {
+            if constexpr (!std::is_trivially_destructible<TKey>::value) nodes[v].key = TKey();
+            nodes[v].right = freeList;
+            freeList = v;
+        }
+
+    public:
+        void reserve(size_t n) {
+            nodes.reserve(n);
+        }
     };
 
-    std::list<std::shared_ptr<Node>> rootList;
-    int n = 0;
-    std::shared_ptr<Node> minNode = nullptr;
+private:
+    std::shared_ptr<Pool> pool;
+    uint32_t minNode = NIL;
+    size_t n = 0;
+
+    // The root of each degree during consolidation, all NIL between calls
+    std::vector<uint32_t> withDegree;
 
     static size_t log2(size_t n) {
         size_t res = 0;
@@ -35,121 +74,289 @@ class FibonacciHeap {
         return res;
     }
 
-    void computeMin() {
-        minNode = nullptr;
-        for (auto &node : rootList) {
-            if (!minNode || Compare()(node->key, minNode->key)) {
-                minNode = node;
+    Node &node(uint32_t v) const {
+        return pool->nodes[v];
+    }
+
+    bool less(uint32_t u, uint32_t v) const {
+        return Compare()(node(u).key, node(v).key);
+    }
+
+    // Join the circular lists containing a and b
+    void splice(uint32_t a, uint32_t b) {
+        uint32_t aNext = node(a).right, bPrev = node(b).left;
+        node(a).right = b;
+        node(b).left = a;
+        node(bPrev).right = aNext;
+        node(aNext).left = bPrev;
+    }
+
+    void unlink(uint32_t v) {
+        node(node(v).left).right = node(v).right;
+        node(node(v).right).left = node(v).left;
+        node(v).left = node(v).right = v;
+    }
+
+    void addRoot(uint32_t v) {
+        node(v).parent = NIL;
+        node(v).marked = false;
+        if (minNode == NIL) minNode = v;
+        else {
+            splice(minNode, v);
+            if (less(v, minNode)) minNode = v;
+        }
+    }
+
+    // Make the root y a child of the root x
+    void link(uint32_t y, uint32_t x) {
+        node(y).parent = x;
+        node(y).marked = false;
+        if (node(x).child == NIL) node(x).child = y;
+        else splice(node(x).child, y);
+        node(x).degree++;
+    }
+
+    // Move v from its parent p's children to the root list
+    void cut(uint32_t v, uint32_t p) {
+        if (node(p).child == v) node(p).child = node(v).right != v ? node(v).right : NIL;
+        unlink(v);
+        node(p).degree--;
+        addRoot(v);
+    }
+
+    // Move v to the root list, then cut its ancestors upwards until one that hasn't lost a child yet, which is marked
+    void cutToRoot(uint32_t v) {
+        uint32_t p = node(v).parent;
+        if (p == NIL) return;
+
+        cut(v, p);
+        for (uint32_t y = p; node(y).parent != NIL; ) {
+            if (!node(y).marked) {
+                node(y).marked = true;
+                break;
             }
+
+            uint32_t z = node(y).parent;
+            cut(y, z);
+            y = z;
         }
     }
 
-    template <typename T>
-    void decreaseKey(std::shared_ptr<Node> node, T &&newKey) {
-        node->key = newKey;
-        if (Compare()(node->key, minNode->key)) minNode = node;
+    // Return every node of the heap to the pool
+    void release() {
+        if (minNode == NIL) return;
+
+        std::vector<uint32_t> stack(1, minNode);
+        while (!stack.empty()) {
+            uint32_t first = stack.back(), v = first;
+            stack.pop_back();
+            do {
+                uint32_t next = node(v).right;
+                if (node(v).child != NIL) stack.push_back(node(v).child);
+                pool->deallocate(v);
+                v = next;
+            } while (v != first);
+        }
+
+        minNode = NIL;
+        n = 0;
+    }
+
+    // Unlink the minimum and consolidate the roots, the removed node is left to the caller
+    void extractMin() {
+        uint32_t z = minNode;
+        if (node(z).child != NIL) {
+            uint32_t ch = node(z).child;
+            do {
+                node(ch).parent = NIL;
+                node(ch).marked = false;
+                ch = node(ch).right;
+            } while (ch != node(z).child);
+
+            splice(z, ch);
+        }
+
+        uint32_t start = node(z).right, last = node(z).left;
+        unlink(z);
+
+        n--;
+        if (n == 0) {
+            minNode = NIL;
+            return;
+        }
+
+        size_t maxDegree = 2 * log2(n) + 2;
+        if (withDegree.size() < maxDegree) withDegree.resize(maxDegree, NIL);
+
+        // Link roots of the same degree in place, the roots left in the list are the result. A root linked under
+        // another has a key not less than it, so the minimum moves to its new parent.
+        minNode = start;
+        size_t usedDegree = 0;
+        for (uint32_t x = start, next; ; x = next) {
+            next = node(x).right;
+            bool isLast = x == last;
+
+            if (less(x, minNode)) minNode = x;
 
-        auto y = node->parent.lock();
-        if (!y || Compare()(y->key, node->key)) return;
+            size_t degree = node(x).degree;
+            while (withDegree[degree] != NIL) {
+                uint32_t y = withDegree[degree];
+                if (less(y, x)) std::swap(x, y);
 
-        std::shared_ptr<Node> x = node;
-        do {
-            auto y = x->parent.lock();
-            y->childList.erase(x->iterator);
-            rootList.push_back(x);
+                unlink(y);
+                link(y, x);
+                if (y == minNode) minNode = x;
 
-            x->iterator = --rootList.end();
-            x->parent = std::weak_ptr<Node>();
-            x->marked = false;
+                withDegree[degree] = NIL;
+                degree++;
+            }
+
+            withDegree[degree] = x;
+            usedDegree = std::max(usedDegree, degree);
+
+            if (isLast) break;
+        }
 
-            x = y;
-        } while (x->marked && x->parent.lock());
+        std::fill(withDegree.begin(), withDegree.begin() + usedDegree + 1, NIL);
+    }
+
+    // Move the nodes of another pool's heap into this heap's pool, returning the new index of its minimum
+    uint32_t adopt(const FibonacciHeap &other) {
+        if (other.minNode == NIL) return NIL;
+
+        std::vector<std::pair<uint32_t, uint32_t>> stack(1, {other.minNode, NIL});
+        uint32_t result = NIL;
+        while (!stack.empty()) {
+            auto [first, parent] = stack.back();
+            stack.pop_back();
+
+            // Copy one sibling list under parent
+            uint32_t head = NIL, v = first;
+            do {
+                const Node &old = other.node(v);
+                uint32_t u = pool->allocate(old.key);
+                node(u).parent = parent;
+                node(u).degree = old.degree;
+                node(u).marked = old.marked;
+                if (head == NIL) head = u;
+                else splice(head, u);
+                if (old.child != NIL) stack.emplace_back(old.child, u);
+
+                v = old.right;
+            } while (v != first);
+
+            if (parent == NIL) result = head;
+            else node(parent).child = head;
+        }
+        return result;
     }
 
 public:
+    // A node's index in the pool, it stays the same until the node is erased or popped. It's passed to the heap holding
+    // the node, which is the heap it was pushed into or a heap that one was melded into.
     class NodeProxy {
         friend FibonacciHeap;
 
-        std::weak_ptr<Node> node;
-        FibonacciHeap *heap;
+        const Pool *pool;
+        uint32_t node;
 
-        NodeProxy(std::shared_ptr<Node> node, FibonacciHeap *heap) : node(node), heap(heap) {}
+        NodeProxy(const Pool *pool, uint32_t node) : pool(pool), node(node) {}
 
     public:
-        NodeProxy() : NodeProxy(nullptr, nullptr) {}
+        NodeProxy() : NodeProxy(nullptr, NIL) {}
         NodeProxy(const NodeProxy &) = default;
+        NodeProxy &operator=(const NodeProxy &) = default;
 
         const TKey &getKey() const {
-            return node.lock()->key;
-        }
-
-        template <typename T>
-        void decreaseKey(T &&newKey) {
-            if (!Compare()(newKey, getKey())) {
-                throw std::logic_error("new key is greater than current key");
-            }
-
-            heap->decreaseKey(node.lock(), newKey);
+            return pool->nodes[node].key;
         }
     };
 
-    template <typename T>
-    NodeProxy push(T &&key) {
-        std::shared_ptr<Node> newNode(new Node(std::move(key)));
-        rootList.push_back(newNode);
-        newNode->iterator = --rootList.end();
+    // Every heap gets its own pool unless one is given. Heaps given the same pool can be melded in O(1), but must not be
+    // used concurrently.
+    explicit FibonacciHeap(std::shared_ptr<Pool> pool = std::make_shared<Pool>()) : pool(pool) {}
 
-        if (!minNode || Compare()(newNode->key, minNode->key)) {
-            minNode = newNode;
-        }
+    FibonacciHeap(const FibonacciHeap &) = delete;
+    FibonacciHeap &operator=(const FibonacciHeap &) = delete;
 
-        n++;
-        return NodeProxy(newNode, this);
+    FibonacciHeap(FibonacciHeap &&other) : pool(other.pool), minNode(other.minNode), n(other.n) {
+        other.minNode = NIL;
+        other.n = 0;
     }
 
-    void deleteMin() {
-        if (!minNode) return;
+    // A pool only used by this heap goes away with it, a shared one gets the nodes back
+    ~FibonacciHeap() {
+        if (pool.use_count() > 1) release();
+    }
 
-        rootList.erase(minNode->iterator);
-        rootList.splice(rootList.end(), minNode->childList);
+    FibonacciHeap &operator=(FibonacciHeap &&other) {
+        std::swap(pool, other.pool);
+        std::swap(minNode, other.minNode);
+        std::swap(n, other.n);
+        return *this;
+    }
 
-        n--;
+    std::shared_ptr<Pool> getPool() const {
+        return pool;
+    }
 
-        size_t maxDegree = 0;
-        for (auto &root : rootList) maxDegree = std::max(maxDegree, root->childList.size());
+    template <typename T>
+    NodeProxy push(T &&key) {
+        uint32_t v = pool->allocate(std::forward<T>(key));
+        addRoot(v);
 
-        std::vector<std::shared_ptr<Node>> withDegree(2 * log2(n) + 1);
-        for (auto &root : rootList) {
-            size_t degree = root->childList.size();
+        n++;
+        return NodeProxy(pool.get(), v);
+    }
 
-            auto x = root;
-            while (auto y = withDegree[degree]) {
-                if (!Compare()(x->key, y->key)) std::swap(x, y);
+    void deleteMin() {
+        if (minNode == NIL) return;
 
-                x->childList.push_back(y);
-                y->parent = x;
-                y->iterator = --x->childList.end();
-                y->marked = false;
+        uint32_t z = minNode;
+        extractMin();
+        pool->deallocate(z);
+    }
 
-                withDegree[degree] = nullptr;
-                degree++;
-            }
+    // Remove the node, the handle must not be used afterwards
+    void erase(const NodeProxy &handle) {
+        uint32_t v = handle.node;
+        cutToRoot(v);
+        minNode = v;
+        deleteMin();
+    }
 
-            withDegree[degree] = x;
+    template <typename T>
+    void decreaseKey(const NodeProxy &handle, T &&newKey) {
+        uint32_t v = handle.node;
+        if (!Compare()(newKey, node(v).key)) {
+            throw std::logic_error("new key is greater than current key");
         }
 
-        std::list<std::shared_ptr<Node>> newRootList;
-        for (auto &root : withDegree) {
-            if (root) newRootList.push_back(root);
+        node(v).key = std::forward<T>(newKey);
+        uint32_t p = node(v).parent;
+        if (p != NIL && less(v, p)) cutToRoot(v);
+        if (less(v, minNode)) minNode = v;
+    }
+
+    // The node's children could become smaller than it, so it's taken out and pushed again as the same node
+    template <typename T>
+    void increaseKey(const NodeProxy &handle, T &&newKey) {
+        uint32_t v = handle.node;
+        if (Compare()(newKey, node(v).key)) {
+            throw std::logic_error("new key is less than current key");
         }
 
-        rootList = std::move(newRootList);
-        for (auto it = rootList.begin(); it != rootList.end(); it++) (*it)->iterator = it; 
-        computeMin();
+        cutToRoot(v);
+        minNode = v;
+        extractMin();
+
+        node(v) = Node(std::forward<T>(newKey), v);
+        addRoot(v);
+        n++;
     }
 
     NodeProxy getMin() {
-        return NodeProxy(minNode, this);
+        return NodeProxy(pool.get(), minNode);
     }
 
     size_t size() const {
@@ -160,12 +367,33 @@ public:
         return n == 0;
     }
 
+    // Move all nodes of other into this heap. Only if both heaps were given the same pool the root lists are spliced in
+    // O(1) and handles into other can be used with this heap. Otherwise its nodes are copied in O(size of other) and
+    // its handles become invalid.
+    void meld(FibonacciHeap &&other) {
+        if (this == &other || other.minNode == NIL) return;
+
+        uint32_t otherMin = other.minNode;
+        size_t otherSize = other.n;
+        if (other.pool != pool) {
+            otherMin = adopt(other);
+            other.release();
+        }
+
+        if (minNode == NIL) minNode = otherMin;
+        else {
+            splice(minNode, otherMin);
+            if (less(otherMin, minNode)) minNode = otherMin;
+        }
+
+        n += otherSize;
+        other.minNode = NIL;
+        other.n = 0;
+    }
+
     static FibonacciHeap<TKey, Compare> merge(FibonacciHeap<TKey, Compare> &&heap1, FibonacciHeap<TKey, Compare> &&heap2) {
-        FibonacciHeap<TKey, Compare> newHeap;
-        newHeap.rootList = std::move(heap1.rootList);
-        newHeap.rootList.splice(newHeap.rootList.end(), heap2.rootList);
-        newHeap.n = heap1.n + heap2.n;
-        newHeap.computeMin();
+        FibonacciHeap<TKey, Compare> newHeap(std::move(heap1));
+        newHeap.meld(std::move(heap2));
         return newHeap;
     }
 };
@@ -3,8 +3,9 @@
 #include <stdexcept>
 #include <algorithm>
 #include <numeric>
+#include <limits>
 
-#include "FibonacciHeap.h"
+#include "../10/FibonacciHeap.h"
 
 std::vector<UEdge> minimumSpanningTree(size_t n, std::vector<UEdge> &edges) {
 	struct Edge;
@@ -39,7 +40,7 @@ std::vector<UEdge> minimumSpanningTree(size_t n, std::vector<UEdge> &edges) {
 	}
 
 	nodes[0].w = 0;
-	nodes[0].nodeInFibonacciHeap.decreaseKey(std::make_pair(0, &nodes[0]));
+	heap.decreaseKey(nodes[0].nodeInFibonacciHeap, std::make_pair(0, &nodes[0]));
 
 	std::vector<UEdge> newEdges;
 	while (!heap.empty()) {
@@ -55,7 +56,7 @@ std::vector<UEdge> minimumSpanningTree(size_t n, std::vector<UEdge> &edges) {
 			if (!edge.to.poped && edge.to.w > edge.w) {
 				edge.to.w = edge.w;
 				edge.to.previousEdge = &edge;
-				edge.to.nodeInFibonacciHeap.decreaseKey(std::make_pair(edge.to.w, &edge.to));
+				heap.decreaseKey(edge.to.nodeInFibonacciHeap, std::make_pair(edge.to.w, &edge.to));
 			}
 		}
 	}
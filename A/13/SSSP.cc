@@ -6,7 +6,7 @@
 #include <limits>
 #include <queue>
 
-#include "FibonacciHeap.h"
+#include "../10/FibonacciHeap.h"
 
 struct Node {
     size_t id;
@@ -106,7 +106,7 @@ void dijkstra(Node *start) {
         for (Edge *e = v->firstEdge; e; e = e->next) {
             if (e->to->dist > v->dist + e->w) {
                 e->to->dist = v->dist + e->w;
-                e->to->nodeInFibonacciHeap.decreaseKey(std::make_pair(e->to->dist, e->to));
+                heap.decreaseKey(e->to->nodeInFibonacciHeap, std::make_pair(e->to->dist, e->to));
             }
         }
     }
@@ -59,6 +59,20 @@ public:
         adjustHeapPop(0);
     }
 
+    // Equivalent to pop() then push(), with a single sift-down
+    template <typename TRef>
+    void replaceTop(TRef &&value) {
+        container.front() = std::forward<TRef>(value);
+        adjustHeapPop(0);
+    }
+
+    // Remove all elements matching the predicate and rebuild the heap in O(n)
+    template <typename Predicate>
+    void removeIf(Predicate predicate) {
+        container.erase(std::remove_if(container.begin(), container.end(), predicate), container.end());
+        for (size_t i = container.size() / 2; i-- > 0; ) adjustHeapPop(i);
+    }
+
     const T &top() const {
         return container.front();
     }
@@ -7,6 +7,12 @@
 #include <chrono>
 #include <algorithm>
 #include <vector>
+#include <array>
+#include <iterator>
+#include <thread>
+#include <cmath>
+
+#include "StreamingSelect.h"
 
 template <typename RAIter, typename Compare>
 RAIter partition(RAIter begin, RAIter end, RAIter pivot, Compare compare) {
@@ -66,6 +72,123 @@ auto &quickSelect(RAIter begin, RAIter nth, RAIter end, Compare compare = Compar
 	else return randomSelect(pivot + 1, nth, end);
 }
 
+// Run task(i) for each i in [0, tasks) on at most `threads` threads
+template <typename Function>
+void parallelFor(size_t tasks, size_t threads, Function task) {
+	threads = std::max<size_t>(1, std::min(threads, tasks));
+
+	std::vector<std::thread> workers;
+	for (size_t t = 1; t < threads; t++) {
+		workers.emplace_back([&, t]() {
+			for (size_t i = t; i < tasks; i += threads) task(i);
+		});
+	}
+
+	for (size_t i = 0; i < tasks; i += threads) task(i);
+	for (auto &worker : workers) worker.join();
+}
+
+// Select the nth (0-based) element of the union of several [begin, end) shards without concatenating them.
+// Two pivots around the target rank are sampled, every thread counts the elements of its chunks below, between and
+// above them, and only the bucket holding the target rank is compacted into a buffer for the next round.
+template <typename RAIter, typename Compare = std::less<typename std::iterator_traits<RAIter>::value_type>>
+auto parallelSelect(const std::vector<std::pair<RAIter, RAIter>> &shards, size_t nth, Compare compare = Compare(),
+                    size_t threads = std::thread::hardware_concurrency()) {
+	using T = typename std::iterator_traits<RAIter>::value_type;
+	const size_t MIN_LEN = 1 << 14, SAMPLE_SIZE = 1 << 12;
+
+	size_t n = 0;
+	for (const auto &shard : shards) n += shard.second - shard.first;
+	assert(nth < n);
+
+	if (threads == 0) threads = 1;
+
+	// Split the shards into chunks of roughly n / threads elements
+	std::vector<std::pair<RAIter, RAIter>> chunks;
+	std::vector<size_t> offsets;
+	size_t chunkLen = n / threads + 1;
+	for (const auto &shard : shards) {
+		for (RAIter it = shard.first; it != shard.second; ) {
+			RAIter next = it + std::min<size_t>(chunkLen, shard.second - it);
+			offsets.push_back(offsets.empty() ? 0 : offsets.back() + (chunks.back().second - chunks.back().first));
+			chunks.emplace_back(it, next);
+			it = next;
+		}
+	}
+
+	std::vector<T> buffer;
+	if (n <= MIN_LEN) {
+		buffer.reserve(n);
+		for (const auto &chunk : chunks) buffer.insert(buffer.end(), chunk.first, chunk.second);
+		std::nth_element(buffer.begin(), buffer.begin() + nth, buffer.end(), compare);
+		return buffer[nth];
+	}
+
+	// Sample the pivots lo and hi, which are expected to surround the nth element
+	static std::mt19937 rng((std::random_device()()));
+	std::uniform_int_distribution<size_t> rd(0, n - 1);
+
+	std::vector<T> samples;
+	for (size_t i = 0; i < SAMPLE_SIZE; i++) {
+		size_t k = rd(rng), c = std::upper_bound(offsets.begin(), offsets.end(), k) - offsets.begin() - 1;
+		samples.push_back(chunks[c].first[k - offsets[c]]);
+	}
+	std::sort(samples.begin(), samples.end(), compare);
+
+	size_t pos = nth * SAMPLE_SIZE / n, delta = std::sqrt(SAMPLE_SIZE);
+	const T lo = samples[pos < delta ? 0 : pos - delta],
+	        hi = samples[std::min(pos + delta, SAMPLE_SIZE - 1)];
+
+	// Bucket 0: x < lo, bucket 1: lo <= x <= hi, bucket 2: hi < x
+	auto bucketOf = [&](const T &x) -> size_t {
+		if (compare(x, lo)) return 0;
+		else if (compare(hi, x)) return 2;
+		else return 1;
+	};
+
+	std::vector<std::array<size_t, 3>> counts(chunks.size());
+	parallelFor(chunks.size(), threads, [&](size_t c) {
+		std::array<size_t, 3> count = {0, 0, 0};
+		for (RAIter it = chunks[c].first; it != chunks[c].second; it++) count[bucketOf(*it)]++;
+		counts[c] = count;
+	});
+
+	std::array<size_t, 3> total = {0, 0, 0};
+	for (const auto &count : counts) for (size_t b = 0; b < 3; b++) total[b] += count[b];
+
+	size_t bucket = 0;
+	while (nth >= total[bucket]) nth -= total[bucket++];
+
+	// All elements between two equal pivots are equal
+	if (bucket == 1 && !compare(lo, hi)) return lo;
+
+	// Compact the chosen bucket, every chunk writes to its own range of the buffer
+	std::vector<size_t> writeOffsets(chunks.size());
+	for (size_t c = 1; c < chunks.size(); c++) writeOffsets[c] = writeOffsets[c - 1] + counts[c - 1][bucket];
+
+	buffer.resize(total[bucket]);
+	parallelFor(chunks.size(), threads, [&](size_t c) {
+		auto out = buffer.begin() + writeOffsets[c];
+		for (RAIter it = chunks[c].first; it != chunks[c].second; it++) {
+			if (bucketOf(*it) == bucket) *out++ = *it;
+		}
+	});
+
+	// No progress (e.g. lo and hi are the minimum and maximum), fall back to sequential selection
+	if (buffer.size() == n) {
+		std::nth_element(buffer.begin(), buffer.begin() + nth, buffer.end(), compare);
+		return buffer[nth];
+	}
+
+	using BufferIter = typename std::vector<T>::iterator;
+	return parallelSelect(std::vector<std::pair<BufferIter, BufferIter>>{{buffer.begin(), buffer.end()}}, nth, compare, threads);
+}
+
+template <typename RAIter, typename Compare = std::less<typename std::iterator_traits<RAIter>::value_type>>
+auto parallelSelect(RAIter begin, RAIter nth, RAIter end, Compare compare = Compare()) {
+	return parallelSelect(std::vector<std::pair<RAIter, RAIter>>{{begin, end}}, nth - begin, compare);
+}
+
 std::vector<uint64_t> generateRandomData(size_t n) {
 	static std::mt19937 rng((std::random_device()()));
 	std::vector<uint64_t> v;
@@ -122,4 +245,46 @@ int main() {
 		auto v0 = data;
 		for (const auto &p : questions) assert(stdSelect(data.begin(), data.begin() + p.first - 1, data.end()) == p.second);
 	});
+
+	measureTime("parallelSelect", [&]() {
+		for (const auto &p : questions) assert(parallelSelect(data.begin(), data.begin() + p.first - 1, data.end()) == p.second);
+	});
+
+	const size_t SHARDS = 4;
+	std::vector<std::vector<long>> shardData(SHARDS);
+	for (size_t i = 0; i < data.size(); i++) shardData[i % SHARDS].push_back(data[i]);
+
+	std::vector<std::pair<std::vector<long>::const_iterator, std::vector<long>::const_iterator>> shards;
+	for (const auto &shard : shardData) shards.emplace_back(shard.begin(), shard.end());
+
+	measureTime("parallelSelect (sharded)", [&]() {
+		for (const auto &p : questions) assert(parallelSelect(shards, p.first - 1) == p.second);
+	});
+
+	const size_t TOP_K = 1000, BATCH_SIZE = 4096;
+	measureTime("StreamingTopK", [&]() {
+		StreamingTopK<long> topK(TOP_K);
+		for (size_t i = 0; i < data.size(); i += BATCH_SIZE) {
+			topK.push(data.begin() + i, data.begin() + std::min(i + BATCH_SIZE, data.size()));
+		}
+
+		auto sorted = data;
+		std::sort(sorted.begin(), sorted.end(), std::greater<long>());
+		sorted.resize(std::min(TOP_K, sorted.size()));
+		assert(topK.result() == sorted);
+	});
+
+	const size_t WINDOW_SIZE = 1000, CHECK_INTERVAL = 997;
+	measureTime("SlidingWindowQuantile", [&]() {
+		SlidingWindowQuantile<long> median(WINDOW_SIZE);
+		for (size_t i = 0; i < data.size(); i++) {
+			median.push(data[i]);
+
+			if (i % CHECK_INTERVAL == 0) {
+				size_t begin = i + 1 < WINDOW_SIZE ? 0 : i + 1 - WINDOW_SIZE;
+				std::vector<long> window(data.begin() + begin, data.begin() + i + 1);
+				assert(median.get() == stdSelect(window.begin(), window.begin() + (window.size() - 1) / 2, window.end()));
+			}
+		}
+	});
 }
@@ -0,0 +1,177 @@
+#ifndef _MENCI_STREAMINGSELECT_H
+#define _MENCI_STREAMINGSELECT_H
+
+#include <algorithm>
+#include <vector>
+#include <utility>
+#include <cmath>
+#include <stdexcept>
+
+#include "../3/MinHeap.h"
+
+// Keeps the k largest elements seen in a stream, with O(k) memory
+template <typename T,
+          typename Compare = std::less<T>>
+class StreamingTopK {
+    MinHeap<T, std::vector<T>, Compare> heap;
+    size_t k;
+    std::vector<T> batch;
+
+public:
+    explicit StreamingTopK(size_t k) : k(k) {}
+
+    void push(const T &value) {
+        if (heap.size() < k) heap.push(value);
+        else if (k != 0 && Compare()(heap.top(), value)) heap.replaceTop(value);
+    }
+
+    // Elements not greater than the current k-th largest are dropped with a single comparison, and a batch larger
+    // than k is cut down to its own k largest with nth_element before touching the heap
+    template <typename InputIter>
+    void push(InputIter begin, InputIter end) {
+        if (k == 0) return;
+
+        batch.clear();
+        for (InputIter it = begin; it != end; it++) {
+            if (heap.size() < k || Compare()(heap.top(), *it)) batch.push_back(*it);
+        }
+
+        if (batch.size() > k) {
+            std::nth_element(batch.begin(), batch.begin() + k, batch.end(), [](const T &a, const T &b) {
+                return Compare()(b, a);
+            });
+            batch.resize(k);
+        }
+
+        for (const T &value : batch) push(value);
+    }
+
+    // The k-th largest element seen so far
+    const T &threshold() const {
+        if (heap.empty()) throw std::logic_error("no element pushed");
+        return heap.top();
+    }
+
+    // The k largest elements, from largest to smallest
+    std::vector<T> result() const {
+        MinHeap<T, std::vector<T>, Compare> copy = heap;
+        std::vector<T> values;
+        for (; !copy.empty(); copy.pop()) values.push_back(copy.top());
+        std::reverse(values.begin(), values.end());
+        return values;
+    }
+
+    size_t size() const {
+        return heap.size();
+    }
+};
+
+// The q-quantile of the last windowSize elements of a stream, with two heaps and lazy deletion.
+//
+// Every element is tagged with its position in the stream, so elements are unique and an element in a heap is stale
+// iff its position fell out of the window. Stale elements are popped when they reach a heap top, and a heap is
+// compacted when stale elements make up more than half of it.
+template <typename T,
+          typename Compare = std::less<T>>
+class SlidingWindowQuantile {
+    struct Item {
+        T value;
+        size_t index;
+    };
+
+    struct ItemLess {
+        bool operator()(const Item &a, const Item &b) const {
+            if (Compare()(a.value, b.value)) return true;
+            if (Compare()(b.value, a.value)) return false;
+            return a.index < b.index;
+        }
+    };
+
+    struct ItemGreater {
+        bool operator()(const Item &a, const Item &b) const {
+            return ItemLess()(b, a);
+        }
+    };
+
+    // lower holds the (rank + 1) smallest elements of the window, upper holds the rest
+    MinHeap<Item, std::vector<Item>, ItemGreater> lower;
+    MinHeap<Item, std::vector<Item>, ItemLess> upper;
+    size_t lowerSize = 0, upperSize = 0;
+
+    std::vector<T> window;
+    size_t windowSize, count = 0;
+    double quantile;
+
+    bool expired(const Item &item) const {
+        return item.index + windowSize < count;
+    }
+
+    template <typename Heap>
+    void prune(Heap &heap, size_t validSize) {
+        while (!heap.empty() && expired(heap.top())) heap.pop();
+
+        if (heap.size() > 2 * validSize + 64) {
+            heap.removeIf([this](const Item &item) { return expired(item); });
+        }
+    }
+
+    template <typename From, typename To>
+    void move(From &from, size_t &fromSize, To &to, size_t &toSize) {
+        to.push(from.top());
+        from.pop();
+        fromSize--;
+        toSize++;
+        prune(from, fromSize);
+    }
+
+public:
+    SlidingWindowQuantile(size_t windowSize, double quantile = 0.5) : window(windowSize), windowSize(windowSize), quantile(quantile) {
+        if (windowSize == 0) throw std::invalid_argument("window size must be positive");
+        if (quantile < 0 || quantile > 1) throw std::invalid_argument("quantile must be in [0, 1]");
+    }
+
+    void push(const T &value) {
+        // Evict the oldest element, the heap tops are always valid so it can be located by comparing with lower's top
+        if (count >= windowSize) {
+            Item oldest{window[count % windowSize], count - windowSize};
+            if (lowerSize != 0 && !ItemLess()(lower.top(), oldest)) lowerSize--;
+            else upperSize--;
+        }
+
+        Item item{value, count};
+        window[count % windowSize] = value;
+        count++;
+
+        prune(lower, lowerSize);
+        prune(upper, upperSize);
+
+        if (upperSize == 0 || ItemLess()(item, upper.top())) {
+            lower.push(item);
+            lowerSize++;
+        } else {
+            upper.push(item);
+            upperSize++;
+        }
+
+        size_t target = static_cast<size_t>(std::floor(quantile * (lowerSize + upperSize - 1))) + 1;
+        while (lowerSize > target) move(lower, lowerSize, upper, upperSize);
+        while (lowerSize < target) move(upper, upperSize, lower, lowerSize);
+    }
+
+    template <typename InputIter>
+    void push(InputIter begin, InputIter end) {
+        for (InputIter it = begin; it != end; it++) push(*it);
+    }
+
+    // The floor(q * (size - 1))-th smallest (0-based) element of the current window
+    const T &get() const {
+        if (lowerSize == 0) throw std::logic_error("no element pushed");
+        return lower.top().value;
+    }
+
+    size_t size() const {
+        return lowerSize + upperSize;
+    }
+};
+
+#endif // _MENCI_STREAMINGSELECT_H
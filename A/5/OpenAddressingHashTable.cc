@@ -1,49 +1,505 @@
 #include <iostream>
 #include <vector>
 #include <cstdint>
-#include <exception>
+#include <stdexcept>
 #include <cassert>
 #include <random>
 #include <functional>
 #include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <optional>
+#include <cstring>
+#include <type_traits>
 
-template <typename TKey, typename TValue, typename HashFunction, size_t SIZE>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// Batched lookups resolve keys in groups of this size, after prefetching the home slots of the whole group
+const size_t PREFETCH_GROUP = 16;
+
+template <typename TKey, typename TValue, typename HashFunction>
 class OpenAddressingHashTable {
     struct HashItem {
         TKey key;
         TValue value;
         bool nonEmpty;
     };
+
+    // While an incremental rehash is in progress, the items of oldData before migrateIndex have been moved into data,
+    // the rest are still only in oldData. A key is never present in both.
+    std::vector<HashItem> data, oldData;
+    size_t migrateIndex = 0, migrateStep = 0, count = 0;
+    double maxLoadFactor;
+    bool incremental;
+
+    // Find the item holding the key, or the first empty item on its probe sequence if the key is absent.
+    // Items before skipBefore are already migrated and never match.
+    static HashItem *find(std::vector<HashItem> &table, const TKey &key, size_t skipBefore = 0) {
+        for (size_t i = 0; i < table.size(); i++) {
+            size_t hash = HashFunction()(key, i, table.size());
+            if (!table[hash].nonEmpty || (hash >= skipBefore && table[hash].key == key)) return &table[hash];
+        }
+        return nullptr;
+    }
+
+    HashItem *findExisting(const TKey &key) {
+        HashItem *item = find(data, key);
+        if (item && item->nonEmpty) return item;
+
+        if (!oldData.empty()) {
+            item = find(oldData, key, migrateIndex);
+            if (item && item->nonEmpty) return item;
+        }
+
+        return nullptr;
+    }
+
+    void migrate(size_t steps) {
+        if (oldData.empty()) return;
+
+        for (; steps > 0 && migrateIndex < oldData.size(); steps--, migrateIndex++) {
+            HashItem &item = oldData[migrateIndex];
+            if (!item.nonEmpty) continue;
+
+            HashItem *target = find(data, item.key);
+            if (!target) throw std::logic_error("hash table full");
+            *target = std::move(item);
+        }
+
+        if (migrateIndex == oldData.size()) {
+            oldData = std::vector<HashItem>();
+            migrateIndex = 0;
+        }
+    }
+
+    void grow() {
+        migrate(oldData.size());
+
+        oldData = std::move(data);
+        data = std::vector<HashItem>(oldData.size() * 2);
+
+        // The migration must finish before data reaches the load factor again, which takes at least
+        // maxLoadFactor * oldData.size() inserts
+        migrateStep = static_cast<size_t>(std::ceil(1 / maxLoadFactor)) + 1;
+        if (!incremental) migrate(oldData.size());
+    }
+
+public:
+    OpenAddressingHashTable(size_t initialCapacity = 16, double maxLoadFactor = 0.75, bool incremental = true)
+        : data(std::max<size_t>(initialCapacity, 1)), maxLoadFactor(maxLoadFactor), incremental(incremental) {
+        if (!(maxLoadFactor > 0 && maxLoadFactor <= 1)) throw std::invalid_argument("load factor must be in (0, 1]");
+    }
+
+    template <typename TValueRef>
+    void set(const TKey &key, TValueRef &&value) {
+        if (HashItem *item = findExisting(key)) {
+            item->value = std::forward<TValueRef>(value);
+            return;
+        }
+
+        if (count + 1 > maxLoadFactor * data.size()) grow();
+        migrate(migrateStep);
+
+        HashItem *item;
+        while (!(item = find(data, key))) grow();
+
+        item->key = key;
+        item->value = std::forward<TValueRef>(value);
+        item->nonEmpty = true;
+        count++;
+    }
+
+    const TValue &get(const TKey &key) {
+        if (HashItem *item = findExisting(key)) return item->value;
+        throw std::logic_error("key not found");
+    }
+
+    // Write a pointer to the value of each key in [begin, end) to out, or nullptr if absent
+    template <typename RAIter, typename OutputIter>
+    void getBatch(RAIter begin, RAIter end, OutputIter out) {
+        while (begin != end) {
+            RAIter groupEnd = begin + std::min<size_t>(PREFETCH_GROUP, end - begin);
+            for (RAIter it = begin; it != groupEnd; it++) __builtin_prefetch(&data[HashFunction()(*it, 0, data.size())]);
+
+            for (; begin != groupEnd; begin++) {
+                HashItem *item = findExisting(*begin);
+                *out++ = item ? &item->value : nullptr;
+            }
+        }
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    size_t capacity() const {
+        return data.size();
+    }
+};
+
+// Mix the bits of std::hash, which is the identity for integers on common implementations
+template <typename TKey>
+struct MixedHash {
+    size_t operator()(const TKey &key) const {
+        uint64_t x = std::hash<TKey>()(key);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return x;
+    }
+};
+
+// Open addressing with a separate control byte per slot, which is either EMPTY or the low 7 bits of the key's hash.
+// Slots are probed in groups of GROUP_SIZE, comparing all control bytes of a group at once with SSE2, so keys are only
+// compared on a fingerprint match, and a lookup stops at the first group with an empty slot.
+template <typename TKey, typename TValue, typename Hash = MixedHash<TKey>>
+class SwissTable {
+    static constexpr size_t GROUP_SIZE = 16;
+    static constexpr int8_t EMPTY = -128;
+
+    std::vector<int8_t> control;
+    std::vector<TKey> keys;
+    std::vector<TValue> values;
+    size_t groupMask, count = 0;
+
+    // Bit i is set iff control byte i of the group starting at slot begin equals byte
+    uint32_t match(size_t begin, int8_t byte) const {
+#ifdef __SSE2__
+        __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&control[begin]));
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(byte)));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < GROUP_SIZE; i++) mask |= uint32_t(control[begin + i] == byte) << i;
+        return mask;
+#endif
+    }
+
+    // Return the slot holding the key, or the first empty slot on its probe sequence if the key is absent
+    size_t find(const TKey &key, size_t hash, bool &found) const {
+        size_t group = (hash >> 7) & groupMask;
+        int8_t fingerprint = hash & 0x7F;
+
+        // Triangular probing visits every group when the number of groups is a power of 2
+        for (size_t step = 1; ; group = (group + step++) & groupMask) {
+            size_t begin = group * GROUP_SIZE;
+            for (uint32_t mask = match(begin, fingerprint); mask; mask &= mask - 1) {
+                size_t i = begin + __builtin_ctz(mask);
+                if (keys[i] == key) {
+                    found = true;
+                    return i;
+                }
+            }
+
+            if (uint32_t mask = match(begin, EMPTY)) {
+                found = false;
+                return begin + __builtin_ctz(mask);
+            }
+        }
+    }
+
+    void resize(size_t groups) {
+        std::vector<int8_t> oldControl = std::move(control);
+        std::vector<TKey> oldKeys = std::move(keys);
+        std::vector<TValue> oldValues = std::move(values);
+
+        control.assign(groups * GROUP_SIZE, EMPTY);
+        keys = std::vector<TKey>(groups * GROUP_SIZE);
+        values = std::vector<TValue>(groups * GROUP_SIZE);
+        groupMask = groups - 1;
+
+        bool found;
+        for (size_t i = 0; i < oldControl.size(); i++) {
+            if (oldControl[i] == EMPTY) continue;
+
+            size_t j = find(oldKeys[i], Hash()(oldKeys[i]), found);
+            control[j] = oldControl[i];
+            keys[j] = std::move(oldKeys[i]);
+            values[j] = std::move(oldValues[i]);
+        }
+    }
+
+public:
+    // The table grows when more than 7/8 of the slots are used
+    SwissTable(size_t initialCapacity = GROUP_SIZE) {
+        size_t groups = 1;
+        while (groups * GROUP_SIZE < initialCapacity) groups *= 2;
+        resize(groups);
+    }
+
+    template <typename TValueRef>
+    void set(const TKey &key, TValueRef &&value) {
+        bool found;
+        size_t hash = Hash()(key), i = find(key, hash, found);
+        if (!found) {
+            if ((count + 1) * 8 > control.size() * 7) {
+                resize(control.size() / GROUP_SIZE * 2);
+                i = find(key, hash, found);
+            }
+
+            control[i] = hash & 0x7F;
+            keys[i] = key;
+            count++;
+        }
+
+        values[i] = std::forward<TValueRef>(value);
+    }
+
+    const TValue &get(const TKey &key) const {
+        bool found;
+        size_t i = find(key, Hash()(key), found);
+        if (!found) throw std::logic_error("key not found");
+        return values[i];
+    }
+
+    // Write a pointer to the value of each key in [begin, end) to out, or nullptr if absent
+    template <typename RAIter, typename OutputIter>
+    void getBatch(RAIter begin, RAIter end, OutputIter out) const {
+        size_t hashes[PREFETCH_GROUP];
+        while (begin != end) {
+            size_t n = std::min<size_t>(PREFETCH_GROUP, end - begin);
+            for (size_t k = 0; k < n; k++) {
+                hashes[k] = Hash()(begin[k]);
+                size_t i = ((hashes[k] >> 7) & groupMask) * GROUP_SIZE;
+                __builtin_prefetch(&control[i]);
+                __builtin_prefetch(&keys[i]);
+            }
+
+            bool found;
+            for (size_t k = 0; k < n; k++, begin++) {
+                size_t i = find(*begin, hashes[k], found);
+                *out++ = found ? &values[i] : nullptr;
+            }
+        }
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    size_t capacity() const {
+        return control.size();
+    }
+};
+
+// Linear probing where an inserted item takes the slot of any item closer to its home slot (Robin Hood), so items on a
+// probe sequence are ordered by their distance from home. A lookup stops at the first item closer to home than the
+// key would be, and erasing shifts the following items back by one slot instead of leaving a tombstone.
+template <typename TKey, typename TValue, typename Hash = MixedHash<TKey>>
+class RobinHoodHashTable {
+    struct HashItem {
+        TKey key;
+        TValue value;
+        size_t distance; // 1 + distance from the home slot, 0 for empty
+    };
     std::vector<HashItem> data;
+    size_t mask, count = 0;
+    double maxLoadFactor;
 
-    HashItem &find(const TKey &key, bool emptyStatus) {
+    // Return the slot holding the key, or data.size() if absent
+    size_t find(const TKey &key, size_t hash) const {
+        size_t i = hash & mask;
+        for (size_t distance = 1; distance <= data[i].distance; distance++, i = (i + 1) & mask) {
+            if (data[i].distance == distance && data[i].key == key) return i;
+        }
+        return data.size();
+    }
+
+    void insert(HashItem item) {
+        size_t i = Hash()(item.key) & mask;
+        for (item.distance = 1; data[i].distance != 0; item.distance++, i = (i + 1) & mask) {
+            if (data[i].distance < item.distance) std::swap(item, data[i]);
+        }
+        data[i] = std::move(item);
+    }
+
+    void resize(size_t capacity) {
+        std::vector<HashItem> oldData = std::move(data);
+        data = std::vector<HashItem>(capacity);
+        mask = capacity - 1;
+
+        for (auto &item : oldData) if (item.distance != 0) insert(std::move(item));
     }
 
 public:
-    OpenAddressingHashTable() : data(SIZE) {}
+    RobinHoodHashTable(size_t initialCapacity = 16, double maxLoadFactor = 0.9) : maxLoadFactor(maxLoadFactor) {
+        if (!(maxLoadFactor > 0 && maxLoadFactor < 1)) throw std::invalid_argument("load factor must be in (0, 1)");
+
+        size_t capacity = 1;
+        while (capacity < initialCapacity) capacity *= 2;
+        resize(capacity);
+    }
 
     template <typename TValueRef>
     void set(const TKey &key, TValueRef &&value) {
-        for (size_t i = 0; i < SIZE; i++) {
-            size_t hash = HashFunction()(key, i, SIZE);
-            if (!data[hash].nonEmpty) {
-                data[hash].key = key;
-                data[hash].value = std::forward<TValueRef>(value);
-                data[hash].nonEmpty = true;
+        size_t i = find(key, Hash()(key));
+        if (i != data.size()) {
+            data[i].value = std::forward<TValueRef>(value);
+            return;
+        }
+
+        if (count + 1 > maxLoadFactor * data.size()) resize(data.size() * 2);
+        insert(HashItem{key, std::forward<TValueRef>(value), 0});
+        count++;
+    }
+
+    const TValue &get(const TKey &key) const {
+        size_t i = find(key, Hash()(key));
+        if (i == data.size()) throw std::logic_error("key not found");
+        return data[i].value;
+    }
+
+    // Write a pointer to the value of each key in [begin, end) to out, or nullptr if absent
+    template <typename RAIter, typename OutputIter>
+    void getBatch(RAIter begin, RAIter end, OutputIter out) const {
+        size_t hashes[PREFETCH_GROUP];
+        while (begin != end) {
+            size_t n = std::min<size_t>(PREFETCH_GROUP, end - begin);
+            for (size_t k = 0; k < n; k++) {
+                hashes[k] = Hash()(begin[k]);
+                __builtin_prefetch(&data[hashes[k] & mask]);
+            }
+
+            for (size_t k = 0; k < n; k++, begin++) {
+                size_t i = find(*begin, hashes[k]);
+                *out++ = i != data.size() ? &data[i].value : nullptr;
+            }
+        }
+    }
+
+    bool erase(const TKey &key) {
+        size_t i = find(key, Hash()(key));
+        if (i == data.size()) return false;
+
+        // Backward shift: pull each following displaced item one slot closer to its home
+        for (size_t j = (i + 1) & mask; data[j].distance > 1; i = j, j = (j + 1) & mask) {
+            data[i] = std::move(data[j]);
+            data[i].distance--;
+        }
+
+        data[i].distance = 0;
+        count--;
+        return true;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    size_t capacity() const {
+        return data.size();
+    }
+};
+
+// Fixed-capacity linear probing for concurrent use. Readers never lock: every slot has a version which is odd while
+// the slot is being written (a seqlock), and a read is retried if the version changed while the value was copied.
+// Writers lock one of STRIPES mutexes chosen by the hash of the key, so writers of the same key are serialized, and
+// claim empty slots with a compare-and-swap. Keys are never removed, so a probe sequence never shrinks.
+template <typename TKey, typename TValue, typename Hash = MixedHash<TKey>>
+class ConcurrentHashTable {
+    static_assert(std::is_trivially_copyable<TKey>::value && std::is_trivially_copyable<TValue>::value,
+                  "keys and values are copied while they may be written");
+
+    static constexpr size_t STRIPES = 64, VALUE_WORDS = (sizeof(TValue) + 7) / 8;
+
+    struct HashItem {
+        std::atomic<uint64_t> version{0}; // 0 for empty, 1 while being claimed
+        TKey key;
+        std::atomic<uint64_t> value[VALUE_WORDS];
+    };
+    std::vector<HashItem> data;
+    size_t mask;
+    std::mutex stripes[STRIPES];
+    std::atomic<size_t> count{0};
+
+    // The value is stored as relaxed atomic words, so a read racing with a write is torn but well-defined
+    static TValue readValue(const HashItem &item) {
+        uint64_t words[VALUE_WORDS];
+        for (size_t i = 0; i < VALUE_WORDS; i++) words[i] = item.value[i].load(std::memory_order_relaxed);
+
+        TValue value;
+        std::memcpy(&value, words, sizeof(TValue));
+        return value;
+    }
+
+    static void writeValue(HashItem &item, const TValue &value) {
+        uint64_t words[VALUE_WORDS] = {};
+        std::memcpy(words, &value, sizeof(TValue));
+        for (size_t i = 0; i < VALUE_WORDS; i++) item.value[i].store(words[i], std::memory_order_relaxed);
+    }
+
+public:
+    ConcurrentHashTable(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) size *= 2;
+        data = std::vector<HashItem>(size);
+        mask = size - 1;
+    }
+
+    void set(const TKey &key, const TValue &value) {
+        size_t hash = Hash()(key), i = hash & mask;
+        std::lock_guard<std::mutex> lock(stripes[hash % STRIPES]);
+
+        for (size_t probes = 0; probes < data.size(); probes++, i = (i + 1) & mask) {
+            HashItem &item = data[i];
+            uint64_t version = item.version.load(std::memory_order_acquire);
+
+            if (version == 0 && item.version.compare_exchange_strong(version, 1, std::memory_order_acquire)) {
+                item.key = key;
+                writeValue(item, value);
+                item.version.store(2, std::memory_order_release);
+                count++;
                 return;
             }
+
+            // A slot being claimed belongs to a key of another stripe, otherwise the key is stable
+            if (version == 1 || !(item.key == key)) continue;
+
+            item.version.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            writeValue(item, value);
+            item.version.fetch_add(1, std::memory_order_release);
+            return;
         }
+
         throw std::logic_error("hash table full");
     }
 
-    const TValue &get(const TKey &key) {
-        for (size_t i = 0; i < SIZE; i++) {
-            size_t hash = HashFunction()(key, i, SIZE);
-            if (!data[hash].nonEmpty) {
-                throw std::logic_error("key not found");
-            } else if (data[hash].key == key) return data[hash].value;
+    std::optional<TValue> get(const TKey &key) const {
+        size_t i = Hash()(key) & mask;
+        for (size_t probes = 0; probes < data.size(); probes++, i = (i + 1) & mask) {
+            const HashItem &item = data[i];
+            for (;;) {
+                uint64_t before = item.version.load(std::memory_order_acquire);
+                if (before == 0) return std::nullopt;
+                if (before & 1) {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                if (!(item.key == key)) break;
+
+                TValue value = readValue(item);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (item.version.load(std::memory_order_relaxed) == before) return value;
+            }
         }
-        throw std::logic_error("key not found");
+
+        return std::nullopt;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    size_t capacity() const {
+        return data.size();
     }
 };
 
@@ -65,7 +521,7 @@ void measureTime(std::string actionName, std::function<void ()> function) {
 }
 
 int main() {
-    const size_t TABLE_SIZE = 1u << 20, DATA_SIZE = 1000000;
+    const size_t DATA_SIZE = 1000000;
     std::vector<uint64_t> data = generateRandomData(DATA_SIZE);
     std::cout << "Random data generated" << std::endl;
 
@@ -75,11 +531,23 @@ int main() {
                 return (key % hashSize + i) % hashSize;
             }
         };
-        OpenAddressingHashTable<uint64_t, uint64_t, LinearProbing, TABLE_SIZE> hashTable;
+        OpenAddressingHashTable<uint64_t, uint64_t, LinearProbing> hashTable;
         measureTime("LinearProbing", [&]() {
             for (auto x : data) hashTable.set(x, x + x);
             for (auto x : data) assert(hashTable.get(x) == x + x);
         });
+
+        measureTime("LinearProbing (batched get)", [&]() {
+            std::vector<const uint64_t *> values(DATA_SIZE);
+            hashTable.getBatch(data.begin(), data.end(), values.begin());
+            for (size_t i = 0; i < DATA_SIZE; i++) assert(values[i] && *values[i] == data[i] + data[i]);
+        });
+
+        OpenAddressingHashTable<uint64_t, uint64_t, LinearProbing> stopTheWorldHashTable(16, 0.75, false);
+        measureTime("LinearProbing (stop-the-world rehash)", [&]() {
+            for (auto x : data) stopTheWorldHashTable.set(x, x + x);
+            for (auto x : data) assert(stopTheWorldHashTable.get(x) == x + x);
+        });
     }
 
     {
@@ -88,7 +556,7 @@ int main() {
                 return ((key % hashSize + 1 * i) % hashSize + 2 * i * i) % hashSize;
             }
         };
-        OpenAddressingHashTable<uint64_t, uint64_t, QuadraticProbing, TABLE_SIZE> hashTable;
+        OpenAddressingHashTable<uint64_t, uint64_t, QuadraticProbing> hashTable;
         measureTime("QuadraticProbing", [&]() {
             for (auto x : data) hashTable.set(x, x + x);
             for (auto x : data) assert(hashTable.get(x) == x + x);
@@ -102,10 +570,104 @@ int main() {
                 return (key % hashSize + i * (key % MOD * 2 + 1)) % hashSize;
             }
         };
-        OpenAddressingHashTable<uint64_t, uint64_t, DoubleHashing, TABLE_SIZE> hashTable;
+        OpenAddressingHashTable<uint64_t, uint64_t, DoubleHashing> hashTable;
         measureTime("DoubleHashing", [&]() {
             for (auto x : data) hashTable.set(x, x + x);
             for (auto x : data) assert(hashTable.get(x) == x + x);
         });
     }
+
+    {
+        SwissTable<uint64_t, uint64_t> hashTable;
+        measureTime("SwissTable", [&]() {
+            for (auto x : data) hashTable.set(x, x + x);
+            for (auto x : data) assert(hashTable.get(x) == x + x);
+        });
+
+        measureTime("SwissTable (batched get)", [&]() {
+            std::vector<const uint64_t *> values(DATA_SIZE);
+            hashTable.getBatch(data.begin(), data.end(), values.begin());
+            for (size_t i = 0; i < DATA_SIZE; i++) assert(values[i] && *values[i] == data[i] + data[i]);
+        });
+    }
+
+    {
+        RobinHoodHashTable<uint64_t, uint64_t> hashTable;
+        measureTime("RobinHoodHashTable", [&]() {
+            for (auto x : data) hashTable.set(x, x + x);
+            for (auto x : data) assert(hashTable.get(x) == x + x);
+        });
+
+        measureTime("RobinHoodHashTable (batched get)", [&]() {
+            std::vector<const uint64_t *> values(DATA_SIZE);
+            hashTable.getBatch(data.begin(), data.end(), values.begin());
+            for (size_t i = 0; i < DATA_SIZE; i++) assert(values[i] && *values[i] == data[i] + data[i]);
+        });
+
+        // Evict and re-insert every key a few times, the probe sequences must not degrade
+        measureTime("RobinHoodHashTable (churn)", [&]() {
+            const size_t ROUNDS = 4;
+            for (size_t round = 0; round < ROUNDS; round++) {
+                for (size_t i = round % 2; i < DATA_SIZE; i += 2) {
+                    [[maybe_unused]] bool erased = hashTable.erase(data[i]);
+                    assert(erased);
+                }
+                for (size_t i = round % 2; i < DATA_SIZE; i += 2) hashTable.set(data[i], data[i] + round);
+                for (size_t i = round % 2; i < DATA_SIZE; i += 2) assert(hashTable.get(data[i]) == data[i] + round);
+            }
+            assert(hashTable.size() == DATA_SIZE);
+        });
+    }
+
+    {
+        // Every value carries its own complement, so a torn read fails the assertion
+        struct CheckedValue {
+            uint64_t value, check;
+        };
+
+        const size_t THREADS = std::max(4u, std::thread::hardware_concurrency()), WRITERS = THREADS / 4,
+                     OPERATIONS_PER_THREAD = DATA_SIZE;
+
+        auto runMixed = [&](std::string name, std::function<void (uint64_t, CheckedValue)> write,
+                            std::function<CheckedValue (uint64_t)> read) {
+            for (auto x : data) write(x, CheckedValue{x, ~x});
+
+            measureTime(name, [&]() {
+                std::vector<std::thread> threads;
+                for (size_t t = 0; t < THREADS; t++) {
+                    threads.emplace_back([&, t]() {
+                        std::mt19937_64 rng(t);
+                        for (size_t i = 0; i < OPERATIONS_PER_THREAD; i++) {
+                            uint64_t x = data[rng() % DATA_SIZE];
+                            if (t < WRITERS) {
+                                uint64_t y = rng();
+                                write(x, CheckedValue{y, ~y});
+                            } else {
+                                CheckedValue value = read(x);
+                                assert(value.check == ~value.value);
+                            }
+                        }
+                    });
+                }
+                for (auto &thread : threads) thread.join();
+            });
+        };
+
+        RobinHoodHashTable<uint64_t, CheckedValue> lockedHashTable;
+        std::mutex mutex;
+        runMixed("RobinHoodHashTable with global mutex (mixed read/write)", [&](uint64_t key, CheckedValue value) {
+            std::lock_guard<std::mutex> lock(mutex);
+            lockedHashTable.set(key, value);
+        }, [&](uint64_t key) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return lockedHashTable.get(key);
+        });
+
+        ConcurrentHashTable<uint64_t, CheckedValue> hashTable(DATA_SIZE * 2);
+        runMixed("ConcurrentHashTable (mixed read/write)", [&](uint64_t key, CheckedValue value) {
+            hashTable.set(key, value);
+        }, [&](uint64_t key) {
+            return *hashTable.get(key);
+        });
+    }
 }
@@ -7,99 +7,514 @@
 #include <functional>
 #include <memory>
 #include <chrono>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <type_traits>
 
+// M is the initial size of each of the two tables. They grow when the stash overflows, or before the number of
+// elements reaches 90% of a table size, since eviction paths get long as the load approaches 50%
 template <typename T, size_t M>
 class CuckooHashing {
+    static constexpr size_t MAX_BFS_SLOTS = 512, STASH_SIZE = 4;
+
     std::vector<std::optional<T>> t[2];
     std::function<size_t (size_t)> f[2];
+    size_t m, n = 0;
 
-    // Get random prime number in [min, max]
-    static size_t getPrime(size_t min, size_t max) {
-        std::vector<bool> isNotPrime(max + 1);
-        std::vector<size_t> primes;
-
-        // Euler sieve
-        isNotPrime[0] = isNotPrime[1] = true;
-        for (size_t i = 2; i <= max; i++) {
-            if (!isNotPrime[i]) primes.push_back(i);
-            for (size_t p : primes) {
-                size_t x = i * p;
-                if (x > max) break;
-
-                isNotPrime[x] = true;
-                if (i % p == 0) break;
-            }
-        }
+    // Elements for which no eviction path was found
+    std::vector<T> stash;
 
-        // Get the random range
-        std::vector<size_t>::const_iterator l = std::lower_bound(primes.begin(), primes.end(), min),
-                                            r = std::upper_bound(primes.begin(), primes.end(), max);
-        
-        std::random_device rng;
-        std::uniform_int_distribution<> dis(0, r - l);
+    struct Slot {
+        size_t which, i, parent;
+    };
+    std::vector<Slot> queue;
 
-        return *(dis(rng) + l);
+    static bool isPrime(size_t n) {
+        if (n < 2) return false;
+        for (size_t i = 2; i * i <= n; i++) if (n % i == 0) return false;
+        return true;
+    }
+
+    // Get random prime number in [min, max], by testing random candidates
+    static size_t getPrime(size_t min, size_t max) {
+        static std::mt19937_64 rng((std::random_device()()));
+        std::uniform_int_distribution<size_t> dis(min, max);
+
+        for (;;) {
+            size_t p = dis(rng);
+            if (isPrime(p)) return p;
+        }
     }
 
-    void init() {
+    void init(size_t size) {
+        m = size;
         t[0].clear();
         t[1].clear();
-        t[0].resize(M);
-        t[1].resize(M);
+        t[0].resize(m);
+        t[1].resize(m);
 
         std::random_device rng;
-        size_t p0 = getPrime(M, 2 * M - 1),
-               a0 = std::uniform_int_distribution<>(1, p0 - 1)(rng),
-               b0 = std::uniform_int_distribution<>(0, p0 - 1)(rng),
-               p1 = getPrime(M, 2 * M - 1),
-               a1 = std::uniform_int_distribution<>(1, p1 - 1)(rng),
-               b1 = std::uniform_int_distribution<>(0, p1 - 1)(rng);
-        
-        f[0] = [p0, a0, b0](const T &x) {
-            return ((a0 * x) % p0 + b0) % p0 % M;
+        size_t p0 = getPrime(m, 2 * m - 1),
+               a0 = std::uniform_int_distribution<size_t>(1, p0 - 1)(rng),
+               b0 = std::uniform_int_distribution<size_t>(0, p0 - 1)(rng),
+               p1 = getPrime(m, 2 * m - 1),
+               a1 = std::uniform_int_distribution<size_t>(1, p1 - 1)(rng),
+               b1 = std::uniform_int_distribution<size_t>(0, p1 - 1)(rng),
+               m = this->m;
+
+        f[0] = [p0, a0, b0, m](const T &x) {
+            return ((a0 * x) % p0 + b0) % p0 % m;
         };
-        f[1] = [p1, a1, b1](const T &x) {
-            return ((a1 * x) % p1 + b1) % p1 % M;
+        f[1] = [p1, a1, b1, m](const T &x) {
+            return ((a1 * x) % p1 + b1) % p1 % m;
         };
     }
 
-    void rebuild() {
-        std::cerr << "rebuild" << std::endl;
-
-        std::vector<T> values;
+    // Double the tables and reinsert everything, growing again if the stash overflows meanwhile
+    void grow() {
+        std::vector<T> values = std::move(stash);
         for (auto &item : t[0]) if (item) values.push_back(std::move(*item));
         for (auto &item : t[1]) if (item) values.push_back(std::move(*item));
 
-        init();
+        for (size_t size = m * 2; ; size *= 2) {
+            init(size);
+            stash.clear();
+
+            bool success = true;
+            for (auto &item : values) if (!(success = place(item))) break;
+            if (success) return;
+        }
+    }
 
-        for (auto &item : values) insert(std::move(item));
+    // Find the shortest eviction path with BFS over slots: an occupied slot leads to the other slot of its element.
+    // Elements are then moved along the path starting from its empty end, so nothing is lost if the search fails.
+    // When no path is found within MAX_BFS_SLOTS slots, x goes to the stash, false is returned if it's full.
+    bool place(const T &x) {
+        return place(x, f[0](x), f[1](x));
     }
 
-    bool insert(const T &x, size_t which, size_t depth) {
-        if (1ULL << depth > M) return false;
+    bool place(const T &x, size_t i0, size_t i1) {
+        queue.clear();
+        queue.push_back({0, i0, SIZE_MAX});
+        queue.push_back({1, i1, SIZE_MAX});
 
-        size_t i = f[which](x);
-        if (t[which][i]) {
-            T y = *t[which][i];
-            if (!insert(y, 1 - which, depth + 1)) return false;
+        for (size_t head = 0; head < queue.size() && queue.size() < MAX_BFS_SLOTS; head++) {
+            Slot slot = queue[head];
+            auto &item = t[slot.which][slot.i];
+
+            if (item) {
+                queue.push_back({slot.which ^ 1, f[slot.which ^ 1](*item), head});
+                continue;
+            }
+
+            size_t k = head;
+            for (; queue[k].parent != SIZE_MAX; k = queue[k].parent) {
+                const Slot &to = queue[k], &from = queue[to.parent];
+                t[to.which][to.i] = std::move(t[from.which][from.i]);
+            }
+            t[queue[k].which][queue[k].i] = x;
+            return true;
         }
 
-        t[which][i] = x;
+        if (stash.size() == STASH_SIZE) return false;
+        stash.push_back(x);
         return true;
     }
 
 public:
     CuckooHashing() {
-        init();
+        init(M);
     }
 
     void insert(const T &x) {
-        while (!insert(x, 0, 0)) rebuild();
+        size_t i0 = f[0](x), i1 = f[1](x);
+        if ((t[0][i0] && *t[0][i0] == x) || (t[1][i1] && *t[1][i1] == x)) return;
+        if (!stash.empty() && std::find(stash.begin(), stash.end(), x) != stash.end()) return;
+
+        n++;
+        if (n > m * 9 / 10) {
+            stash.push_back(x);
+            grow();
+        } else if (!place(x, i0, i1)) {
+            stash.push_back(x);
+            grow();
+        }
     }
 
     bool find(const T &x) {
         size_t i0 = f[0](x), i1 = f[1](x);
-        return (t[0][i0] && *t[0][i0] == x) || (t[1][i1] && *t[1][i1] == x);
+        return (t[0][i0] && *t[0][i0] == x) || (t[1][i1] && *t[1][i1] == x) ||
+               std::find(stash.begin(), stash.end(), x) != stash.end();
+    }
+
+    // Write whether each element of [begin, end) is present to out. Elements are resolved in groups, after the slots
+    // of the whole group have been prefetched, so the cache misses of a group overlap.
+    template <typename RAIter, typename OutputIter>
+    void findBatch(RAIter begin, RAIter end, OutputIter out) {
+        const size_t PREFETCH_GROUP = 16;
+        size_t i[PREFETCH_GROUP][2];
+
+        while (begin != end) {
+            size_t n = std::min<size_t>(PREFETCH_GROUP, end - begin);
+            for (size_t k = 0; k < n; k++) {
+                i[k][0] = f[0](begin[k]);
+                i[k][1] = f[1](begin[k]);
+                __builtin_prefetch(&t[0][i[k][0]]);
+                __builtin_prefetch(&t[1][i[k][1]]);
+            }
+
+            for (size_t k = 0; k < n; k++, begin++) {
+                const T &x = *begin;
+                *out++ = (t[0][i[k][0]] && *t[0][i[k][0]] == x) || (t[1][i[k][1]] && *t[1][i[k][1]] == x) ||
+                         std::find(stash.begin(), stash.end(), x) != stash.end();
+            }
+        }
+    }
+};
+
+// Cuckoo hashing with buckets of SLOTS elements, each bucket aligned to fit in a cache line, so a lookup reads at most
+// two cache lines. The hash functions are multiply-shift with random odd multipliers, mapped to the bucket range with
+// a 128-bit multiply instead of a division. Empty slots hold the EMPTY sentinel, and EMPTY itself is stored aside.
+template <typename T, T EMPTY = std::numeric_limits<T>::max()>
+class BucketizedCuckooHashing {
+    static constexpr size_t SLOTS = 4, MAX_KICKS = 2000;
+
+    struct alignas(SLOTS * sizeof(T)) Bucket {
+        T slots[SLOTS];
+    };
+
+    std::vector<Bucket> buckets;
+    uint64_t a[2];
+    size_t n = 0;
+    bool hasEmpty = false;
+    std::mt19937_64 rng;
+
+    size_t bucketOf(const T &x, size_t which) const {
+        uint64_t hash = a[which] * static_cast<uint64_t>(x);
+        return static_cast<unsigned __int128>(hash) * buckets.size() >> 64;
+    }
+
+    bool insertIntoBucket(size_t i, const T &x) {
+        for (T &slot : buckets[i].slots) {
+            if (slot == EMPTY) {
+                slot = x;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void init(size_t bucketCount) {
+        buckets.assign(bucketCount, Bucket());
+        for (Bucket &bucket : buckets) std::fill(std::begin(bucket.slots), std::end(bucket.slots), EMPTY);
+        a[0] = rng() | 1;
+        a[1] = rng() | 1;
+    }
+
+    // Random walk: put x into one of its buckets, or kick a random element of a full bucket to its other bucket.
+    // On failure x is the last kicked element, which is left without a slot.
+    bool place(T &x) {
+        size_t i = bucketOf(x, 0);
+        for (size_t kicks = 0; kicks < MAX_KICKS; kicks++) {
+            if (insertIntoBucket(i, x)) return true;
+
+            size_t j = bucketOf(x, 1);
+            if (j != i && insertIntoBucket(j, x)) return true;
+
+            if (rng() & 1) i = j;
+            std::swap(x, buckets[i].slots[rng() % SLOTS]);
+
+            size_t i0 = bucketOf(x, 0);
+            i = i0 == i ? bucketOf(x, 1) : i0;
+        }
+        return false;
+    }
+
+    // Rehash all elements and x with new hash functions, growing the table if that fails repeatedly
+    void rebuild(const T &x) {
+        std::vector<T> values{x};
+        for (const Bucket &bucket : buckets) {
+            for (const T &slot : bucket.slots) if (slot != EMPTY) values.push_back(slot);
+        }
+
+        const size_t MAX_ATTEMPTS = 4;
+        for (size_t bucketCount = buckets.size(); ; bucketCount += bucketCount / 8 + 1) {
+            for (size_t attempt = 0; attempt < MAX_ATTEMPTS; attempt++) {
+                init(bucketCount);
+
+                bool success = true;
+                for (T value : values) if (!(success = place(value))) break;
+                if (success) return;
+            }
+        }
+    }
+
+public:
+    BucketizedCuckooHashing(size_t capacity) : rng(std::random_device()()) {
+        init(std::max<size_t>(1, (capacity + SLOTS - 1) / SLOTS));
+    }
+
+    void insert(const T &x) {
+        if (find(x)) return;
+
+        T homeless = x;
+        if (x == EMPTY) hasEmpty = true;
+        else if (!place(homeless)) rebuild(homeless);
+        n++;
+    }
+
+    bool find(const T &x) const {
+        if (x == EMPTY) return hasEmpty;
+
+        const Bucket &b0 = buckets[bucketOf(x, 0)], &b1 = buckets[bucketOf(x, 1)];
+        bool found = false;
+        for (size_t k = 0; k < SLOTS; k++) found |= (b0.slots[k] == x) | (b1.slots[k] == x);
+        return found;
+    }
+
+    size_t size() const {
+        return n;
+    }
+
+    double loadFactor() const {
+        return double(n) / (buckets.size() * SLOTS);
+    }
+};
+
+// A trivially copyable T stored as relaxed atomic words, so it can be copied while being written. Such a copy may be
+// torn, which the reader detects with a version counter.
+template <typename T>
+class AtomicStorage {
+    static_assert(std::is_trivially_copyable<T>::value, "T is copied while it may be written");
+    static constexpr size_t WORDS = (sizeof(T) + 7) / 8;
+
+    std::atomic<uint64_t> words[WORDS];
+
+public:
+    T load() const {
+        uint64_t buffer[WORDS];
+        for (size_t i = 0; i < WORDS; i++) buffer[i] = words[i].load(std::memory_order_relaxed);
+
+        T value;
+        std::memcpy(&value, buffer, sizeof(T));
+        return value;
+    }
+
+    void store(const T &value) {
+        uint64_t buffer[WORDS] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+        for (size_t i = 0; i < WORDS; i++) words[i].store(buffer[i], std::memory_order_relaxed);
+    }
+};
+
+// Fixed-capacity concurrent cuckoo map with 4-way buckets, in the style of MemC3 and libcuckoo.
+//
+// Buckets are guarded by a striped array of version counters. A writer makes the counters of the buckets it touches
+// odd while it holds them, so the counters are both the writer locks and the versions of optimistic reads: a reader
+// copies the two buckets of a key without locking, and retries if either counter was odd or changed meanwhile.
+// When both buckets of a new key are full, a BFS finds an eviction path without locking, then the elements are moved
+// one at a time from the free end of the path, each move locking and re-validating only its two buckets.
+template <typename TKey, typename TValue>
+class ConcurrentCuckooMap {
+    static constexpr size_t SLOTS = 4, MAX_BFS_BUCKETS = 256, MAX_ATTEMPTS = 64;
+
+    struct Bucket {
+        std::atomic<bool> occupied[SLOTS];
+        AtomicStorage<TKey> keys[SLOTS];
+        AtomicStorage<TValue> values[SLOTS];
+    };
+
+    struct alignas(64) Lock {
+        std::atomic<uint64_t> version{0};
+    };
+
+    std::vector<Bucket> buckets;
+    std::vector<Lock> locks;
+    uint64_t a[2];
+
+    size_t bucketOf(const TKey &key, size_t which) const {
+        uint64_t hash = a[which] * static_cast<uint64_t>(std::hash<TKey>()(key));
+        return static_cast<unsigned __int128>(hash) * buckets.size() >> 64;
+    }
+
+    std::atomic<uint64_t> &lockOf(size_t bucket) const {
+        return const_cast<Lock &>(locks[bucket % locks.size()]).version;
+    }
+
+    static void lock(std::atomic<uint64_t> &version) {
+        for (;;) {
+            uint64_t v = version.load(std::memory_order_relaxed);
+            if (!(v & 1) && version.compare_exchange_weak(v, v + 1, std::memory_order_acquire)) break;
+            std::this_thread::yield();
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    static void unlock(std::atomic<uint64_t> &version) {
+        version.fetch_add(1, std::memory_order_release);
+    }
+
+    // Lock the stripes of two buckets in a fixed order, or once if they share a stripe
+    void lockPair(size_t b0, size_t b1) {
+        std::atomic<uint64_t> *l0 = &lockOf(b0), *l1 = &lockOf(b1);
+        if (l0 > l1) std::swap(l0, l1);
+        lock(*l0);
+        if (l1 != l0) lock(*l1);
+    }
+
+    void unlockPair(size_t b0, size_t b1) {
+        std::atomic<uint64_t> *l0 = &lockOf(b0), *l1 = &lockOf(b1);
+        unlock(*l0);
+        if (l1 != l0) unlock(*l1);
+    }
+
+    // Return the slot of the key in the bucket, or SLOTS if absent
+    size_t slotOf(size_t bucket, const TKey &key) const {
+        const Bucket &b = buckets[bucket];
+        for (size_t s = 0; s < SLOTS; s++) {
+            if (b.occupied[s].load(std::memory_order_relaxed) && b.keys[s].load() == key) return s;
+        }
+        return SLOTS;
+    }
+
+    size_t freeSlotOf(size_t bucket) const {
+        const Bucket &b = buckets[bucket];
+        for (size_t s = 0; s < SLOTS; s++) if (!b.occupied[s].load(std::memory_order_relaxed)) return s;
+        return SLOTS;
+    }
+
+    void write(size_t bucket, size_t slot, const TKey &key, const TValue &value) {
+        Bucket &b = buckets[bucket];
+        b.keys[slot].store(key);
+        b.values[slot].store(value);
+        b.occupied[slot].store(true, std::memory_order_relaxed);
+    }
+
+    // Make room in bucket b0 or b1 by moving elements along an eviction path, false if none found or it went stale
+    bool makeRoom(size_t b0, size_t b1) {
+        struct Node {
+            size_t bucket, parent, slot; // slot: which slot of the parent bucket moves into this bucket
+        };
+
+        std::vector<Node> queue{{b0, SIZE_MAX, 0}, {b1, SIZE_MAX, 0}};
+        size_t head = 0;
+        for (; head < queue.size() && freeSlotOf(queue[head].bucket) == SLOTS; head++) {
+            if (queue.size() + SLOTS > MAX_BFS_BUCKETS) continue;
+
+            const Bucket &b = buckets[queue[head].bucket];
+            for (size_t s = 0; s < SLOTS; s++) {
+                TKey key = b.keys[s].load();
+                size_t alternate = bucketOf(key, 0);
+                if (alternate == queue[head].bucket) alternate = bucketOf(key, 1);
+                if (alternate != queue[head].bucket) queue.push_back({alternate, head, s});
+            }
+        }
+        if (head == queue.size()) return false;
+
+        // Move from the free end of the path towards its root
+        for (size_t k = head; queue[k].parent != SIZE_MAX; k = queue[k].parent) {
+            size_t to = queue[k].bucket, from = queue[queue[k].parent].bucket, slot = queue[k].slot;
+            lockPair(from, to);
+
+            Bucket &b = buckets[from];
+            TKey key = b.keys[slot].load();
+            size_t free = freeSlotOf(to);
+            bool valid = b.occupied[slot].load(std::memory_order_relaxed) && free != SLOTS &&
+                         (bucketOf(key, 0) == to || bucketOf(key, 1) == to);
+
+            if (valid) {
+                write(to, free, key, b.values[slot].load());
+                b.occupied[slot].store(false, std::memory_order_relaxed);
+            }
+
+            unlockPair(from, to);
+            if (!valid) return false;
+        }
+
+        return true;
+    }
+
+public:
+    ConcurrentCuckooMap(size_t capacity, size_t lockCount = 8192)
+        : buckets(std::max<size_t>(1, (capacity + SLOTS - 1) / SLOTS)), locks(lockCount) {
+        std::mt19937_64 rng((std::random_device()()));
+        a[0] = rng() | 1;
+        a[1] = rng() | 1;
+
+        for (Bucket &bucket : buckets) for (auto &occupied : bucket.occupied) occupied.store(false);
+    }
+
+    std::optional<TValue> find(const TKey &key) const {
+        size_t b0 = bucketOf(key, 0), b1 = bucketOf(key, 1);
+        const std::atomic<uint64_t> &l0 = lockOf(b0), &l1 = lockOf(b1);
+
+        for (;;) {
+            uint64_t v0 = l0.load(std::memory_order_acquire), v1 = l1.load(std::memory_order_acquire);
+            if ((v0 | v1) & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::optional<TValue> result;
+            if (size_t s = slotOf(b0, key); s != SLOTS) result = buckets[b0].values[s].load();
+            else if (size_t s = slotOf(b1, key); s != SLOTS) result = buckets[b1].values[s].load();
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (l0.load(std::memory_order_relaxed) == v0 && l1.load(std::memory_order_relaxed) == v1) return result;
+        }
+    }
+
+    // Insert the key if absent, return whether it was inserted
+    bool insert(const TKey &key, const TValue &value) {
+        size_t b0 = bucketOf(key, 0), b1 = bucketOf(key, 1);
+
+        for (size_t attempt = 0; attempt < MAX_ATTEMPTS; attempt++) {
+            lockPair(b0, b1);
+
+            bool present = slotOf(b0, key) != SLOTS || slotOf(b1, key) != SLOTS;
+            size_t s0 = freeSlotOf(b0), s1 = freeSlotOf(b1);
+            if (!present && s0 != SLOTS) write(b0, s0, key, value);
+            else if (!present && s1 != SLOTS) write(b1, s1, key, value);
+
+            unlockPair(b0, b1);
+            if (present) return false;
+            if (s0 != SLOTS || s1 != SLOTS) return true;
+
+            makeRoom(b0, b1);
+        }
+
+        throw std::logic_error("hash table full");
+    }
+
+    // Replace the value of the key if present, return whether it was present
+    bool update(const TKey &key, const TValue &value) {
+        size_t b0 = bucketOf(key, 0), b1 = bucketOf(key, 1);
+        lockPair(b0, b1);
+
+        bool present = true;
+        if (size_t s = slotOf(b0, key); s != SLOTS) buckets[b0].values[s].store(value);
+        else if (size_t s = slotOf(b1, key); s != SLOTS) buckets[b1].values[s].store(value);
+        else present = false;
+
+        unlockPair(b0, b1);
+        return present;
+    }
+
+    // Remove the key if present, return whether it was present
+    bool erase(const TKey &key) {
+        size_t b0 = bucketOf(key, 0), b1 = bucketOf(key, 1);
+        lockPair(b0, b1);
+
+        bool present = true;
+        if (size_t s = slotOf(b0, key); s != SLOTS) buckets[b0].occupied[s].store(false, std::memory_order_relaxed);
+        else if (size_t s = slotOf(b1, key); s != SLOTS) buckets[b1].occupied[s].store(false, std::memory_order_relaxed);
+        else present = false;
+
+        unlockPair(b0, b1);
+        return present;
     }
 };
 
@@ -136,4 +551,66 @@ int main() {
             assert(h.find(data[i]));
         }
     });
+
+    measureTime("Check hash table (batched)", [&]() {
+        std::vector<bool> found(DATA_SIZE);
+        h.findBatch(data.begin(), data.end(), found.begin());
+        for (size_t i = 0; i < DATA_SIZE; i++) {
+            assert(found[i]);
+        }
+    });
+
+    BucketizedCuckooHashing<uint64_t> bucketized(DATA_SIZE / 0.95);
+
+    measureTime("Insert data (bucketized)", [&]() {
+        for (auto x : data) bucketized.insert(x);
+    });
+    std::cout << "Bucketized load factor: " << bucketized.loadFactor() << std::endl;
+
+    measureTime("Check hash table (bucketized)", [&]() {
+        for (size_t i = 0; i < DATA_SIZE; i++) {
+            assert(bucketized.find(data[i]));
+        }
+    });
+
+    // Every value carries its own complement, so a torn read fails the assertion
+    struct CheckedValue {
+        uint64_t value, check;
+    };
+
+    ConcurrentCuckooMap<uint64_t, CheckedValue> concurrent(DATA_SIZE / 0.9);
+
+    measureTime("Insert data (concurrent)", [&]() {
+        for (auto x : data) {
+            [[maybe_unused]] bool inserted = concurrent.insert(x, CheckedValue{x, ~x});
+            assert(inserted);
+        }
+    });
+
+    // Read-mostly workload: 90% find, 5% update, 5% erase and re-insert
+    const size_t MAX_THREADS = std::max(4u, std::thread::hardware_concurrency()), OPERATIONS = 8000000;
+    for (size_t threadCount = 1; threadCount <= MAX_THREADS; threadCount *= 2) {
+        measureTime("Read-mostly operations (concurrent, " + std::to_string(threadCount) + " threads)", [&]() {
+            std::vector<std::thread> threads;
+            for (size_t t = 0; t < threadCount; t++) {
+                threads.emplace_back([&, t]() {
+                    std::mt19937_64 rng(t);
+                    for (size_t i = 0; i < OPERATIONS / threadCount; i++) {
+                        uint64_t x = data[rng() % DATA_SIZE], y = rng();
+                        switch (rng() % 20) {
+                        case 0:
+                            concurrent.update(x, CheckedValue{y, ~y});
+                            break;
+                        case 1:
+                            if (concurrent.erase(x)) concurrent.insert(x, CheckedValue{y, ~y});
+                            break;
+                        default:
+                            if (auto value = concurrent.find(x)) assert(value->check == ~value->value);
+                        }
+                    }
+                });
+            }
+            for (auto &thread : threads) thread.join();
+        });
+    }
 }
@@ -6,7 +6,33 @@
 #include <cassert>
 #include <optional>
 #include <memory>
+#include <functional>
 #include <chrono>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <stdexcept>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// File layout of a built PerfectHashing table, every field is 64-bit: the header, m buckets, the occupancy bitmap of
+// all slots, then the slots. The second-level slots of bucket i are slots[offset, offset + size).
+struct PerfectHashingFileHeader {
+    static constexpr uint64_t MAGIC = 0x3148534148464550; // "PEFHASH1"
+
+    uint64_t magic, valueSize, n, m, p, a, b, slotCount;
+};
+
+struct PerfectHashingFileBucket {
+    uint64_t a, b, offset, size;
+};
 
 template <typename T>
 class PerfectHashing {
@@ -125,17 +151,282 @@ public:
     template <typename Container>
     PerfectHashing(Container c) : PerfectHashing(std::begin(c), std::end(c)) {}
 
+    // Write the built table in the format read by MappedPerfectHashing
+    void save(const std::string &path) const {
+        static_assert(std::is_trivially_copyable<T>::value && alignof(T) <= 8, "values are stored as raw bytes");
+
+        std::vector<PerfectHashingFileBucket> buckets;
+        uint64_t slotCount = 0;
+        for (auto &[a, b, v] : data) {
+            buckets.push_back({a, b, slotCount, v.size()});
+            slotCount += v.size();
+        }
+
+        std::vector<uint64_t> occupied((slotCount + 63) / 64);
+        std::vector<T> slots;
+        slots.reserve(slotCount);
+        for (auto &[a, b, v] : data) {
+            for (auto &slot : v) {
+                if (slot) occupied[slots.size() / 64] |= 1ULL << (slots.size() % 64);
+                slots.push_back(slot ? *slot : T());
+            }
+        }
+
+        PerfectHashingFileHeader header{PerfectHashingFileHeader::MAGIC, sizeof(T), n, m, p, a, b, slotCount};
+
+        std::ofstream fout(path, std::ios::binary);
+        fout.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        fout.write(reinterpret_cast<const char *>(buckets.data()), buckets.size() * sizeof(PerfectHashingFileBucket));
+        fout.write(reinterpret_cast<const char *>(occupied.data()), occupied.size() * sizeof(uint64_t));
+        fout.write(reinterpret_cast<const char *>(slots.data()), slots.size() * sizeof(T));
+        if (!fout) throw std::runtime_error("failed to write " + path);
+    }
+
     bool operator[](const T &x) const {
         size_t i = hashFunction(x);
         
         auto &[a, b, v] = data[i];
-        if (a == 0) return false;
+        if (v.empty()) return false;
         
         size_t j = hashFunction(x, i);
         if (v[j]) return *v[j] == x;
 
         return false;
     }
+
+    // Write whether each element of [begin, end) is present to out. Lookups are software pipelined: the bucket of
+    // element i + 2 * DISTANCE is prefetched, the slot of element i + DISTANCE is computed from its bucket, which is
+    // in cache by then, and prefetched, and element i is resolved from its slot.
+    template <typename RAIter, typename OutputIter>
+    void findBatch(RAIter begin, RAIter end, OutputIter out) const {
+        const size_t DISTANCE = 8;
+        size_t n = end - begin, buckets[DISTANCE * 2];
+        const std::optional<T> *slots[DISTANCE];
+
+        auto stageBucket = [&](size_t i) {
+            buckets[i % (DISTANCE * 2)] = hashFunction(begin[i]);
+            __builtin_prefetch(&data[buckets[i % (DISTANCE * 2)]]);
+        };
+
+        auto stageSlot = [&](size_t i) {
+            auto &[a, b, v] = data[buckets[i % (DISTANCE * 2)]];
+            const std::optional<T> *slot = nullptr;
+            if (!v.empty()) {
+                slot = &v[((a * begin[i]) % p + b) % p % v.size()];
+                __builtin_prefetch(slot);
+            }
+            slots[i % DISTANCE] = slot;
+        };
+
+        for (size_t i = 0; i < std::min(n, DISTANCE * 2); i++) stageBucket(i);
+        for (size_t i = 0; i < std::min(n, DISTANCE); i++) stageSlot(i);
+
+        for (size_t i = 0; i < n; i++) {
+            const std::optional<T> *slot = slots[i % DISTANCE];
+            *out++ = slot && *slot && **slot == begin[i];
+
+            if (i + DISTANCE < n) stageSlot(i + DISTANCE);
+            if (i + DISTANCE * 2 < n) stageBucket(i + DISTANCE * 2);
+        }
+    }
+};
+
+// A table written by PerfectHashing::save, mapped into memory and queried in place
+template <typename T>
+class MappedPerfectHashing {
+    void *address = MAP_FAILED;
+    size_t length = 0;
+
+    const PerfectHashingFileHeader *header;
+    const PerfectHashingFileBucket *buckets;
+    const uint64_t *occupied;
+    const T *slots;
+
+public:
+    explicit MappedPerfectHashing(const std::string &path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("failed to open " + path);
+
+        struct stat st;
+        if (fstat(fd, &st) == 0) {
+            length = st.st_size;
+            address = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        if (address == MAP_FAILED) throw std::runtime_error("failed to map " + path);
+
+        header = static_cast<const PerfectHashingFileHeader *>(address);
+        buckets = reinterpret_cast<const PerfectHashingFileBucket *>(header + 1);
+
+        // The header fields are checked against the file length before any pointer is formed from them
+        bool valid = length >= sizeof(PerfectHashingFileHeader) &&
+                     header->magic == PerfectHashingFileHeader::MAGIC && header->valueSize == sizeof(T) &&
+                     header->m != 0 && header->p != 0;
+        size_t bucketBytes, occupiedBytes, slotBytes, expected;
+        if (valid) {
+            valid = !__builtin_mul_overflow(header->m, sizeof(PerfectHashingFileBucket), &bucketBytes) &&
+                    !__builtin_mul_overflow(header->slotCount / 64 + (header->slotCount % 64 != 0), sizeof(uint64_t), &occupiedBytes) &&
+                    !__builtin_mul_overflow(header->slotCount, sizeof(T), &slotBytes) &&
+                    !__builtin_add_overflow(sizeof(PerfectHashingFileHeader), bucketBytes, &expected) &&
+                    !__builtin_add_overflow(expected, occupiedBytes, &expected) &&
+                    !__builtin_add_overflow(expected, slotBytes, &expected) &&
+                    expected == length;
+        }
+        if (valid) {
+            occupied = reinterpret_cast<const uint64_t *>(buckets + header->m);
+            slots = reinterpret_cast<const T *>(occupied + occupiedBytes / sizeof(uint64_t));
+        }
+
+        if (!valid) {
+            munmap(address, length);
+            throw std::runtime_error("invalid perfect hashing file " + path);
+        }
+    }
+
+    MappedPerfectHashing(const MappedPerfectHashing &) = delete;
+    MappedPerfectHashing &operator=(const MappedPerfectHashing &) = delete;
+
+    ~MappedPerfectHashing() {
+        munmap(address, length);
+    }
+
+    bool operator[](const T &x) const {
+        uint64_t p = header->p;
+        const PerfectHashingFileBucket &bucket = buckets[((header->a * x) % p + header->b) % p % header->m];
+        if (bucket.size == 0) return false;
+
+        // A corrupted bucket must not point outside the slots
+        size_t j = ((bucket.a * x) % p + bucket.b) % p % bucket.size;
+        if (bucket.offset >= header->slotCount || j >= header->slotCount - bucket.offset) return false;
+
+        j += bucket.offset;
+        return (occupied[j / 64] >> (j % 64) & 1) && slots[j] == x;
+    }
+};
+
+// Run task(i) for each i in [0, tasks) on at most `threads` threads
+template <typename Function>
+void parallelFor(size_t tasks, size_t threads, Function task) {
+    threads = std::max<size_t>(1, std::min(threads, tasks));
+
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            for (size_t i = t; i < tasks; i += threads) task(i);
+        });
+    }
+
+    for (size_t i = 0; i < tasks; i += threads) task(i);
+    for (auto &worker : workers) worker.join();
+}
+
+// Minimal perfect hashing in the style of BBHash: maps each of the n distinct keys to a distinct index in [0, n), so values can
+// be kept in a flat array, using about 3-4 bits per key. Keys not in the set map to an arbitrary index.
+//
+// Level l is a bit array of gamma * (keys left) bits. Every key left hashes to one bit, and a bit is set iff exactly
+// one key hits it. Keys hitting the same bit are left to the next level. The index of a key is the rank of its bit
+// among all set bits of all levels. The few keys left after MAX_LEVELS levels are kept sorted aside.
+template <typename T>
+class MinimalPerfectHashing {
+    static constexpr size_t MAX_LEVELS = 32, WORDS_PER_RANK = 8;
+
+    std::vector<uint64_t> bits, ranks;
+    std::vector<size_t> levelOffsets, levelSizes;
+    std::vector<T> fallback;
+    size_t n;
+
+    static uint64_t hashFunction(const T &x, size_t level) {
+        uint64_t h = std::hash<T>()(x) ^ (0x9e3779b97f4a7c15ULL * (level + 1));
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // Map a hash to [0, size) with a multiply instead of a division
+    static size_t reduce(uint64_t hash, size_t size) {
+        return static_cast<unsigned __int128>(hash) * size >> 64;
+    }
+
+    size_t rank(size_t position) const {
+        size_t word = position / 64, result = ranks[word / WORDS_PER_RANK];
+        for (size_t i = word / WORDS_PER_RANK * WORDS_PER_RANK; i < word; i++) result += __builtin_popcountll(bits[i]);
+        return result + __builtin_popcountll(bits[word] & ((1ULL << (position % 64)) - 1));
+    }
+
+public:
+    template <typename RAIter>
+    MinimalPerfectHashing(RAIter begin, RAIter end, double gamma = 2, size_t threads = std::thread::hardware_concurrency())
+        : n(std::distance(begin, end)) {
+        const size_t CHUNK_SIZE = 1 << 16;
+        std::vector<T> keys(begin, end);
+
+        for (size_t level = 0; level < MAX_LEVELS && !keys.empty(); level++) {
+            size_t size = (static_cast<size_t>(gamma * keys.size()) + 63) / 64 * 64, chunks = (keys.size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+
+            std::vector<std::atomic<uint64_t>> seen(size / 64), collided(size / 64);
+            parallelFor(chunks, threads, [&](size_t c) {
+                for (size_t i = c * CHUNK_SIZE; i < std::min((c + 1) * CHUNK_SIZE, keys.size()); i++) {
+                    size_t position = reduce(hashFunction(keys[i], level), size);
+                    uint64_t bit = 1ULL << (position % 64);
+                    if (seen[position / 64].fetch_or(bit, std::memory_order_relaxed) & bit) {
+                        collided[position / 64].fetch_or(bit, std::memory_order_relaxed);
+                    }
+                }
+            });
+
+            levelOffsets.push_back(bits.size() * 64);
+            levelSizes.push_back(size);
+            for (size_t i = 0; i < size / 64; i++) bits.push_back(seen[i] & ~collided[i]);
+
+            // Keep the keys which collided, every chunk compacting into its own list
+            std::vector<std::vector<T>> left(chunks);
+            parallelFor(chunks, threads, [&](size_t c) {
+                for (size_t i = c * CHUNK_SIZE; i < std::min((c + 1) * CHUNK_SIZE, keys.size()); i++) {
+                    size_t position = reduce(hashFunction(keys[i], level), size);
+                    if (collided[position / 64] >> (position % 64) & 1) left[c].push_back(keys[i]);
+                }
+            });
+
+            keys.clear();
+            for (auto &chunk : left) keys.insert(keys.end(), chunk.begin(), chunk.end());
+        }
+
+        fallback = std::move(keys);
+        std::sort(fallback.begin(), fallback.end());
+
+        size_t sum = 0;
+        for (size_t i = 0; i < bits.size(); i++) {
+            if (i % WORDS_PER_RANK == 0) ranks.push_back(sum);
+            sum += __builtin_popcountll(bits[i]);
+        }
+    }
+
+    template <typename Container>
+    MinimalPerfectHashing(const Container &c) : MinimalPerfectHashing(std::begin(c), std::end(c)) {}
+
+    size_t operator()(const T &x) const {
+        for (size_t level = 0; level < levelSizes.size(); level++) {
+            size_t position = levelOffsets[level] + reduce(hashFunction(x, level), levelSizes[level]);
+            if (bits[position / 64] >> (position % 64) & 1) return rank(position);
+        }
+
+        // Not in the set
+        if (fallback.empty()) return 0;
+
+        size_t i = std::lower_bound(fallback.begin(), fallback.end(), x) - fallback.begin();
+        return n - fallback.size() + std::min(i, fallback.size() - 1);
+    }
+
+    size_t size() const {
+        return n;
+    }
+
+    size_t sizeInBits() const {
+        return (bits.size() + ranks.size()) * 64 + fallback.size() * sizeof(T) * 8 + levelSizes.size() * 128;
+    }
 };
 
 std::vector<uint64_t> generateRandomData(size_t n) {
@@ -171,4 +462,61 @@ int main() {
             assert((*h)[data[i]]);
         }
     });
+
+    // Both write to a buffer filled beforehand, so only the lookups are timed
+    std::vector<char> found(DATA_SIZE);
+
+    measureTime("Check hash table (scalar)", [&]() {
+        for (size_t i = 0; i < DATA_SIZE; i++) found[i] = (*h)[data[i]];
+    });
+
+    for (size_t i = 0; i < DATA_SIZE; i++) {
+        assert(found[i]);
+        found[i] = false;
+    }
+
+    measureTime("Check hash table (batched)", [&]() {
+        h->findBatch(data.begin(), data.end(), found.begin());
+    });
+
+    for (size_t i = 0; i < DATA_SIZE; i++) {
+        assert(found[i]);
+    }
+
+    const std::string FILE_NAME = "PerfectHashing.bin";
+
+    measureTime("Save hash table", [&]() {
+        h->save(FILE_NAME);
+    });
+
+    std::shared_ptr<MappedPerfectHashing<uint64_t>> mapped;
+
+    measureTime("Load hash table (mmap)", [&]() {
+        mapped = std::make_shared<MappedPerfectHashing<uint64_t>>(FILE_NAME);
+    });
+
+    measureTime("Check hash table (mmap)", [&]() {
+        for (size_t i = 0; i < DATA_SIZE; i++) {
+            assert((*mapped)[data[i]]);
+        }
+    });
+
+    mapped.reset();
+    std::remove(FILE_NAME.c_str());
+
+    std::shared_ptr<MinimalPerfectHashing<uint64_t>> mph;
+
+    measureTime("Create minimal perfect hash", [&]() {
+        mph = std::make_shared<MinimalPerfectHashing<uint64_t>>(data);
+    });
+    std::cout << "Minimal perfect hash uses " << double(mph->sizeInBits()) / DATA_SIZE << " bits per key" << std::endl;
+
+    measureTime("Check minimal perfect hash", [&]() {
+        std::vector<bool> used(DATA_SIZE);
+        for (size_t i = 0; i < DATA_SIZE; i++) {
+            size_t index = (*mph)(data[i]);
+            assert(index < DATA_SIZE && !used[index]);
+            used[index] = true;
+        }
+    });
 }
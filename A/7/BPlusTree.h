@@ -0,0 +1,313 @@
+#ifndef _MENCI_BPLUSTREE_H
+#define _MENCI_BPLUSTREE_H
+
+#include <vector>
+#include <cstdint>
+#include <cassert>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// The number of keys in keys[0, n) less than (or not greater than) x, without branching on the comparisons
+template <typename T>
+uint32_t countLess(const T *keys, uint32_t n, const T &x) {
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < n; i++) result += keys[i] < x;
+    return result;
+}
+
+template <typename T>
+uint32_t countNotGreater(const T *keys, uint32_t n, const T &x) {
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < n; i++) result += !(x < keys[i]);
+    return result;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// AVX2 only has signed 64-bit comparison, so flip the sign bits first
+template <bool keysGreater>
+__attribute__((target("avx2,popcnt")))
+uint32_t countGreaterAVX2(const uint64_t *keys, uint32_t n, uint64_t x) {
+    const __m256i bias = _mm256_set1_epi64x(INT64_MIN);
+    __m256i vx = _mm256_xor_si256(_mm256_set1_epi64x(x), bias);
+
+    uint32_t result = 0, i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i k = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i)), bias);
+        __m256i greater = keysGreater ? _mm256_cmpgt_epi64(k, vx) : _mm256_cmpgt_epi64(vx, k);
+        result += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(greater)));
+    }
+    for (; i < n; i++) result += keysGreater ? keys[i] > x : keys[i] < x;
+    return result;
+}
+
+// Checked once at start up instead of on every call, the AVX2 path is used without building for AVX2
+inline const bool countWithAVX2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"));
+#endif
+
+inline uint32_t countLess(const uint64_t *keys, uint32_t n, uint64_t x) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (countWithAVX2) return countGreaterAVX2<false>(keys, n, x);
+#endif
+    return countLess<uint64_t>(keys, n, x);
+}
+
+inline uint32_t countNotGreater(const uint64_t *keys, uint32_t n, uint64_t x) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (countWithAVX2) return n - countGreaterAVX2<true>(keys, n, x);
+#endif
+    return countNotGreater<uint64_t>(keys, n, x);
+}
+
+// An ordered multiset with the interface of RedBlackTree. Nodes are NODE_SIZE bytes and cache line aligned, so a
+// lookup touches one node per level instead of one key, and leaves are linked for scans.
+template <typename T>
+class BPlusTree {
+    static constexpr uint32_t NIL = UINT32_MAX;
+    static constexpr size_t NODE_SIZE = 256;
+    static constexpr uint32_t LEAF_CAPACITY = (NODE_SIZE - 3 * sizeof(uint32_t)) / sizeof(T),
+                              INNER_CAPACITY = (NODE_SIZE - 2 * sizeof(uint32_t)) / (sizeof(T) + sizeof(uint32_t));
+    static_assert(LEAF_CAPACITY >= 4 && INNER_CAPACITY >= 4, "keys are too large for a node");
+
+    struct alignas(64) Leaf {
+        T keys[LEAF_CAPACITY];
+        uint32_t count, prev, next;
+    };
+
+    // Keys in children[i] are not greater than keys[i], which is not greater than keys in children[i + 1]
+    struct alignas(64) Inner {
+        T keys[INNER_CAPACITY];
+        uint32_t children[INNER_CAPACITY + 1], count;
+    };
+
+    std::vector<Leaf> leaves;
+    std::vector<Inner> inners;
+
+    // root is a leaf when there're no inner levels
+    uint32_t root, height, firstLeaf, lastLeaf;
+    size_t n;
+
+    uint32_t newLeaf() {
+        if (leaves.size() >= NIL) throw std::length_error("too many nodes");
+        leaves.emplace_back();
+        leaves.back().count = 0;
+        leaves.back().prev = leaves.back().next = NIL;
+        return leaves.size() - 1;
+    }
+
+    uint32_t newInner() {
+        if (inners.size() >= NIL) throw std::length_error("too many nodes");
+        inners.emplace_back();
+        inners.back().count = 0;
+        return inners.size() - 1;
+    }
+
+    // The leaf where the first value not less than x (or greater than x if strict) would be
+    uint32_t findLeaf(const T &x, bool strict) const {
+        uint32_t v = root;
+        for (uint32_t level = 0; level < height; level++) {
+            const Inner &inner = inners[v];
+            v = inner.children[strict ? countNotGreater(inner.keys, inner.count, x) : countLess(inner.keys, inner.count, x)];
+        }
+        return v;
+    }
+
+    // Split a full leaf in half, return the new right half
+    uint32_t splitLeaf(uint32_t v) {
+        uint32_t u = newLeaf();
+        Leaf &left = leaves[v], &right = leaves[u];
+
+        uint32_t half = left.count / 2;
+        std::copy(left.keys + half, left.keys + left.count, right.keys);
+        right.count = left.count - half;
+        left.count = half;
+
+        right.prev = v;
+        right.next = left.next;
+        if (left.next != NIL) leaves[left.next].prev = u;
+        else lastLeaf = u;
+        left.next = u;
+
+        return u;
+    }
+
+    // Split a full inner node, the middle key moves up
+    uint32_t splitInner(uint32_t v, T &separator) {
+        uint32_t u = newInner();
+        Inner &left = inners[v], &right = inners[u];
+
+        uint32_t half = left.count / 2;
+        separator = left.keys[half];
+        std::copy(left.keys + half + 1, left.keys + left.count, right.keys);
+        std::copy(left.children + half + 1, left.children + left.count + 1, right.children);
+        right.count = left.count - half - 1;
+        left.count = half;
+
+        return u;
+    }
+
+    template <typename Node>
+    static void insertAt(Node &node, uint32_t position, const T &key) {
+        std::copy_backward(node.keys + position, node.keys + node.count, node.keys + node.count + 1);
+        node.keys[position] = key;
+        node.count++;
+    }
+
+    void validate(uint32_t v, uint32_t level, const T *lo, const T *hi, std::vector<uint32_t> &leafOrder) const {
+        if (level == height) {
+            const Leaf &leaf = leaves[v];
+            assert(leaf.count > 0 || n == 0);
+            for (uint32_t i = 0; i < leaf.count; i++) {
+                if (i > 0) assert(!(leaf.keys[i] < leaf.keys[i - 1]));
+                if (lo) assert(!(leaf.keys[i] < *lo));
+                if (hi) assert(!(*hi < leaf.keys[i]));
+            }
+            leafOrder.push_back(v);
+            return;
+        }
+
+        const Inner &inner = inners[v];
+        assert(inner.count > 0);
+        for (uint32_t i = 0; i <= inner.count; i++) {
+            if (i < inner.count) {
+                if (i > 0) assert(!(inner.keys[i] < inner.keys[i - 1]));
+                if (lo) assert(!(inner.keys[i] < *lo));
+                if (hi) assert(!(*hi < inner.keys[i]));
+            }
+            validate(inner.children[i], level + 1, i > 0 ? &inner.keys[i - 1] : lo, i < inner.count ? &inner.keys[i] : hi, leafOrder);
+        }
+    }
+
+public:
+    BPlusTree() : height(0), n(0) {
+        root = firstLeaf = lastLeaf = newLeaf();
+    }
+
+    void reserve(size_t count) {
+        leaves.reserve(count / (LEAF_CAPACITY / 2) + 1);
+        inners.reserve(count / (LEAF_CAPACITY / 2) / (INNER_CAPACITY / 2) + 1);
+    }
+
+    void insert(const T &x) {
+        // The inner nodes on the way down and the child taken in each
+        uint32_t path[64], position[64];
+        uint32_t v = root;
+        for (uint32_t level = 0; level < height; level++) {
+            path[level] = v;
+            position[level] = countNotGreater(inners[v].keys, inners[v].count, x);
+            v = inners[v].children[position[level]];
+        }
+
+        n++;
+        if (leaves[v].count < LEAF_CAPACITY) {
+            insertAt(leaves[v], countNotGreater(leaves[v].keys, leaves[v].count, x), x);
+            return;
+        }
+
+        uint32_t u = splitLeaf(v);
+        if (x < leaves[u].keys[0]) insertAt(leaves[v], countNotGreater(leaves[v].keys, leaves[v].count, x), x);
+        else insertAt(leaves[u], countNotGreater(leaves[u].keys, leaves[u].count, x), x);
+        T separator = leaves[u].keys[0];
+
+        // Insert (separator, u) right after v in the parent, splitting upwards while full
+        for (uint32_t level = height; level-- > 0;) {
+            v = path[level];
+            uint32_t i = position[level];
+            if (inners[v].count == INNER_CAPACITY) {
+                T middle;
+                uint32_t w = splitInner(v, middle);
+                if (i > inners[v].count) {
+                    v = w;
+                    i -= inners[path[level]].count + 1;
+                }
+
+                Inner &inner = inners[v];
+                std::copy_backward(inner.children + i + 1, inner.children + inner.count + 1, inner.children + inner.count + 2);
+                inner.children[i + 1] = u;
+                insertAt(inner, i, separator);
+
+                separator = middle;
+                u = w;
+            } else {
+                Inner &inner = inners[v];
+                std::copy_backward(inner.children + i + 1, inner.children + inner.count + 1, inner.children + inner.count + 2);
+                inner.children[i + 1] = u;
+                insertAt(inner, i, separator);
+                return;
+            }
+        }
+
+        // The root was split
+        uint32_t newRoot = newInner();
+        inners[newRoot].keys[0] = separator;
+        inners[newRoot].children[0] = root;
+        inners[newRoot].children[1] = u;
+        inners[newRoot].count = 1;
+        root = newRoot;
+        height++;
+    }
+
+    // The greatest value less than x
+    const T *predecessor(const T &x) const {
+        uint32_t v = findLeaf(x, false);
+        uint32_t i = countLess(leaves[v].keys, leaves[v].count, x);
+        if (i == 0) {
+            v = leaves[v].prev;
+            if (v == NIL) return nullptr;
+            i = leaves[v].count;
+        }
+        return &leaves[v].keys[i - 1];
+    }
+
+    // The least value greater than x
+    const T *successor(const T &x) const {
+        uint32_t v = findLeaf(x, true);
+        uint32_t i = countNotGreater(leaves[v].keys, leaves[v].count, x);
+        if (i == leaves[v].count) {
+            v = leaves[v].next;
+            if (v == NIL) return nullptr;
+            i = 0;
+        }
+        return &leaves[v].keys[i];
+    }
+
+    const T *minimum() const {
+        return n ? &leaves[firstLeaf].keys[0] : nullptr;
+    }
+
+    const T *maximum() const {
+        return n ? &leaves[lastLeaf].keys[leaves[lastLeaf].count - 1] : nullptr;
+    }
+
+    // Call f for every value in [lo, hi) in order, walking the leaf list after one descent
+    template <typename Function>
+    void rangeScan(const T &lo, const T &hi, Function f) const {
+        uint32_t v = findLeaf(lo, false);
+        for (uint32_t i = countLess(leaves[v].keys, leaves[v].count, lo); v != NIL; v = leaves[v].next, i = 0) {
+            const Leaf &leaf = leaves[v];
+            for (; i < leaf.count; i++) {
+                if (!(leaf.keys[i] < hi)) return;
+                f(leaf.keys[i]);
+            }
+        }
+    }
+
+    size_t size() const {
+        return n;
+    }
+
+    void validate() const {
+        std::vector<uint32_t> leafOrder;
+        validate(root, 0, nullptr, nullptr, leafOrder);
+
+        assert(leafOrder.front() == firstLeaf && leafOrder.back() == lastLeaf);
+        for (size_t i = 0; i < leafOrder.size(); i++) {
+            assert(leaves[leafOrder[i]].prev == (i > 0 ? leafOrder[i - 1] : NIL));
+            assert(leaves[leafOrder[i]].next == (i + 1 < leafOrder.size() ? leafOrder[i + 1] : NIL));
+        }
+    }
+};
+
+#endif // _MENCI_BPLUSTREE_H
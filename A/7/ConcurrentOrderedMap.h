@@ -0,0 +1,306 @@
+#ifndef _MENCI_CONCURRENTORDEREDMAP_H
+#define _MENCI_CONCURRENTORDEREDMAP_H
+
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <optional>
+#include <utility>
+#include <cstdint>
+#include <stdexcept>
+
+// A persistent red-black tree: an insert copies the path from the root and publishes the new root atomically, so a
+// reader takes a snapshot by loading the root and never blocks or sees a half-done insert. Writers are serialized.
+// Nodes replaced by an insert are reused once every reader that might still see them has released its snapshot.
+template <typename TKey, typename TValue>
+class ConcurrentOrderedMap {
+    enum Relation {
+        L = 0,
+        R = 1
+    };
+
+    static constexpr uint32_t NIL = UINT32_MAX, CHUNK_BITS = 16, CHUNK_SIZE = 1 << CHUNK_BITS;
+    static constexpr size_t RECLAIM_BATCH = 1024;
+
+    // Nodes are never changed after being published
+    struct Node {
+        uint32_t child[2];
+        bool red;
+        TKey key;
+        TValue value;
+    };
+
+    // Nodes live in fixed-size chunks which never move, so readers can index them while the writer adds chunks
+    std::vector<std::unique_ptr<Node[]>> chunks;
+    uint32_t allocated = 0;
+    std::vector<uint32_t> freeNodes;
+
+    struct alignas(64) ReaderSlot {
+        std::atomic<bool> used{false};
+        std::atomic<uint64_t> epoch{0};
+    };
+
+    std::unique_ptr<ReaderSlot[]> slots;
+    size_t maxReaders;
+
+    // The root is swapped after each insert, then the epoch is bumped, and the replaced nodes are tagged with the
+    // epoch before the bump. They're freed when every active reader announced a later epoch.
+    std::atomic<uint32_t> root{NIL};
+    std::atomic<uint64_t> epoch{1};
+    std::vector<std::pair<uint64_t, uint32_t>> retired;
+    std::vector<uint32_t> path;
+    std::atomic<size_t> n{0};
+    std::mutex writeMutex;
+
+    Node &node(uint32_t v) const {
+        return chunks[v >> CHUNK_BITS][v & (CHUNK_SIZE - 1)];
+    }
+
+    bool isRed(uint32_t v) const {
+        return v != NIL && node(v).red;
+    }
+
+    uint32_t allocate() {
+        if (!freeNodes.empty()) {
+            uint32_t v = freeNodes.back();
+            freeNodes.pop_back();
+            return v;
+        }
+
+        if ((allocated >> CHUNK_BITS) >= chunks.size()) throw std::length_error("too many nodes");
+        if ((allocated & (CHUNK_SIZE - 1)) == 0) chunks[allocated >> CHUNK_BITS].reset(new Node[CHUNK_SIZE]);
+        return allocated++;
+    }
+
+    // A fresh copy of a published node, which can be changed until it's published
+    uint32_t copy(uint32_t v) {
+        uint32_t u = allocate();
+        node(u) = node(v);
+        path.push_back(v);
+        return u;
+    }
+
+    // Fix a red child with a red grandchild under the fresh black node v (Okasaki's balance). Only fresh nodes on the
+    // insertion path can be red-red, so the three nodes are rearranged in place.
+    uint32_t balance(uint32_t v) {
+        if (isRed(v)) return v;
+
+        for (int d = Relation::L; d <= Relation::R; d++) {
+            uint32_t c = node(v).child[d];
+            if (!isRed(c)) continue;
+
+            for (int e = Relation::L; e <= Relation::R; e++) {
+                uint32_t g = node(c).child[e];
+                if (!isRed(g)) continue;
+
+                // x < y < z with subtrees a, b, c, d in order
+                uint32_t x, y, z, sub[4];
+                if (d == Relation::L && e == Relation::L) {
+                    x = g, y = c, z = v;
+                    sub[0] = node(g).child[Relation::L], sub[1] = node(g).child[Relation::R];
+                    sub[2] = node(c).child[Relation::R], sub[3] = node(v).child[Relation::R];
+                } else if (d == Relation::L) {
+                    x = c, y = g, z = v;
+                    sub[0] = node(c).child[Relation::L], sub[1] = node(g).child[Relation::L];
+                    sub[2] = node(g).child[Relation::R], sub[3] = node(v).child[Relation::R];
+                } else if (e == Relation::L) {
+                    x = v, y = g, z = c;
+                    sub[0] = node(v).child[Relation::L], sub[1] = node(g).child[Relation::L];
+                    sub[2] = node(g).child[Relation::R], sub[3] = node(c).child[Relation::R];
+                } else {
+                    x = v, y = c, z = g;
+                    sub[0] = node(v).child[Relation::L], sub[1] = node(c).child[Relation::L];
+                    sub[2] = node(g).child[Relation::L], sub[3] = node(g).child[Relation::R];
+                }
+
+                node(x).child[Relation::L] = sub[0], node(x).child[Relation::R] = sub[1], node(x).red = false;
+                node(z).child[Relation::L] = sub[2], node(z).child[Relation::R] = sub[3], node(z).red = false;
+                node(y).child[Relation::L] = x, node(y).child[Relation::R] = z, node(y).red = true;
+                return y;
+            }
+        }
+
+        return v;
+    }
+
+    uint32_t insert(uint32_t v, const TKey &key, const TValue &value, bool &inserted) {
+        if (v == NIL) {
+            uint32_t u = allocate();
+            node(u) = Node{{NIL, NIL}, true, key, value};
+            inserted = true;
+            return u;
+        }
+
+        uint32_t u = copy(v);
+        if (key < node(u).key) {
+            uint32_t ch = insert(node(u).child[Relation::L], key, value, inserted);
+            node(u).child[Relation::L] = ch;
+        } else if (node(u).key < key) {
+            uint32_t ch = insert(node(u).child[Relation::R], key, value, inserted);
+            node(u).child[Relation::R] = ch;
+        } else {
+            node(u).value = value;
+            return u;
+        }
+
+        return balance(u);
+    }
+
+    void reclaim() {
+        uint64_t oldest = UINT64_MAX;
+        for (size_t i = 0; i < maxReaders; i++) {
+            if (!slots[i].used.load()) continue;
+            uint64_t e = slots[i].epoch.load();
+            if (e != 0) oldest = std::min(oldest, e);
+        }
+
+        size_t kept = 0;
+        for (auto &item : retired)
+            if (item.first < oldest) freeNodes.push_back(item.second);
+            else retired[kept++] = item;
+        retired.resize(kept);
+    }
+
+public:
+    // A consistent view of the map, queries on it never block. Writers keep the nodes it can see until it's destroyed.
+    class Snapshot {
+        friend ConcurrentOrderedMap;
+
+        const ConcurrentOrderedMap *map;
+        ReaderSlot *slot;
+        uint32_t root;
+
+        Snapshot(const ConcurrentOrderedMap *map, ReaderSlot *slot) : map(map), slot(slot) {
+            slot->epoch.store(map->epoch.load());
+            root = map->root.load();
+        }
+
+        // The nearest node on the given side of key
+        uint32_t nearest(const TKey &key, int direction) const {
+            uint32_t v = root, result = NIL;
+            while (v != NIL) {
+                const Node &node = map->node(v);
+                if (direction == Relation::L ? node.key < key : key < node.key) {
+                    result = v;
+                    v = node.child[direction ^ 1];
+                } else v = node.child[direction];
+            }
+            return result;
+        }
+
+        uint32_t extreme(int direction) const {
+            uint32_t v = root;
+            while (v != NIL && map->node(v).child[direction] != NIL) v = map->node(v).child[direction];
+            return v;
+        }
+
+        std::optional<std::pair<TKey, TValue>> entry(uint32_t v) const {
+            if (v == NIL) return std::nullopt;
+            return std::make_pair(map->node(v).key, map->node(v).value);
+        }
+
+    public:
+        Snapshot(const Snapshot &) = delete;
+        Snapshot &operator=(const Snapshot &) = delete;
+
+        Snapshot(Snapshot &&other) : map(other.map), slot(other.slot), root(other.root) {
+            other.slot = nullptr;
+        }
+
+        ~Snapshot() {
+            if (!slot) return;
+            slot->epoch.store(0);
+            slot->used.store(false);
+        }
+
+        std::optional<TValue> find(const TKey &key) const {
+            uint32_t v = root;
+            while (v != NIL) {
+                const Node &node = map->node(v);
+                if (key < node.key) v = node.child[Relation::L];
+                else if (node.key < key) v = node.child[Relation::R];
+                else return node.value;
+            }
+            return std::nullopt;
+        }
+
+        // The entry with the greatest key less than key
+        std::optional<std::pair<TKey, TValue>> predecessor(const TKey &key) const {
+            return entry(nearest(key, Relation::L));
+        }
+
+        // The entry with the least key greater than key
+        std::optional<std::pair<TKey, TValue>> successor(const TKey &key) const {
+            return entry(nearest(key, Relation::R));
+        }
+
+        std::optional<std::pair<TKey, TValue>> minimum() const {
+            return entry(extreme(Relation::L));
+        }
+
+        std::optional<std::pair<TKey, TValue>> maximum() const {
+            return entry(extreme(Relation::R));
+        }
+    };
+
+    explicit ConcurrentOrderedMap(size_t maxReaders = 256) : chunks(size_t(NIL) / CHUNK_SIZE), slots(new ReaderSlot[maxReaders]), maxReaders(maxReaders) {}
+
+    // Take one of the reader slots, there can be at most maxReaders snapshots at a time
+    Snapshot snapshot() const {
+        size_t start = std::hash<std::thread::id>()(std::this_thread::get_id());
+        for (size_t i = 0; i < maxReaders; i++) {
+            ReaderSlot &slot = slots[(start + i) % maxReaders];
+            bool expected = false;
+            if (!slot.used.load(std::memory_order_relaxed) && slot.used.compare_exchange_strong(expected, true))
+                return Snapshot(this, &slot);
+        }
+        throw std::runtime_error("too many readers");
+    }
+
+    // Insert or assign
+    void insert(const TKey &key, const TValue &value) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+
+        bool inserted = false;
+        path.clear();
+        uint32_t newRoot = insert(root.load(std::memory_order_relaxed), key, value, inserted);
+        node(newRoot).red = false;
+
+        root.store(newRoot);
+        uint64_t e = epoch.fetch_add(1);
+        if (inserted) n.fetch_add(1, std::memory_order_relaxed);
+
+        for (uint32_t v : path) retired.emplace_back(e, v);
+        if (retired.size() >= RECLAIM_BATCH) reclaim();
+    }
+
+    std::optional<TValue> find(const TKey &key) const {
+        return snapshot().find(key);
+    }
+
+    std::optional<std::pair<TKey, TValue>> predecessor(const TKey &key) const {
+        return snapshot().predecessor(key);
+    }
+
+    std::optional<std::pair<TKey, TValue>> successor(const TKey &key) const {
+        return snapshot().successor(key);
+    }
+
+    std::optional<std::pair<TKey, TValue>> minimum() const {
+        return snapshot().minimum();
+    }
+
+    std::optional<std::pair<TKey, TValue>> maximum() const {
+        return snapshot().maximum();
+    }
+
+    size_t size() const {
+        return n.load(std::memory_order_relaxed);
+    }
+};
+
+#endif // _MENCI_CONCURRENTORDEREDMAP_H
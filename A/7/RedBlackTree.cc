@@ -5,6 +5,15 @@
 #include <functional>
 #include <chrono>
 #include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <iterator>
+#include <thread>
+#include <atomic>
+#include <string>
+
+#include "BPlusTree.h"
+#include "ConcurrentOrderedMap.h"
 
 template <typename T>
 class RedBlackTree {
@@ -13,162 +22,683 @@ class RedBlackTree {
         R = 1
     };
 
+    enum Color {
+        Red, Black
+    };
+
+    static constexpr uint32_t NIL = 0x7FFFFFFF, COLOR_BIT = 0x80000000;
+
+    // Nodes live in one arena and refer to each other by 32-bit index, the color is the highest bit of the parent index
     struct Node {
-        Node *child[2], *parent, **root;
-        enum Color {
-            Red, Black
-        } color;
+        uint32_t child[2], parentAndColor, blackHeight, size;
         T value;
-        size_t blackHeight;
 
-        Node(const T &value, Node *parent, Color color, Node **root) : parent(parent), root(root), color(color), value(value), blackHeight(1) {
-            child[Relation::L] = child[Relation::R] = nullptr;
+        Node(const T &value, uint32_t parent, Color color) : parentAndColor(parent), blackHeight(1), size(1), value(value) {
+            child[Relation::L] = child[Relation::R] = NIL;
+            setColor(color);
         }
 
-        void calcBlackHeight() {
-            const Node *ch = child[Relation::L] ? child[Relation::L] : child[Relation::R];
-            blackHeight = ch ? ch->blackHeight + (ch->color == Color::Black) : 1;
+        uint32_t parent() const {
+            return parentAndColor & ~COLOR_BIT;
         }
 
-        Relation which() const {
-            assert(parent != nullptr);
-            return this == parent->child[Relation::R] ? Relation::R : Relation::L;
+        void setParent(uint32_t parent) {
+            parentAndColor = (parentAndColor & COLOR_BIT) | parent;
         }
 
-        Node *grandparent() {
-            return !parent ? nullptr : parent->parent;
+        Color color() const {
+            return parentAndColor & COLOR_BIT ? Color::Black : Color::Red;
         }
 
-        Node *uncle() {
-            return !grandparent() ? nullptr : grandparent()->child[parent->which() ^ 1];
+        void setColor(Color color) {
+            parentAndColor = (parentAndColor & ~COLOR_BIT) | (color == Color::Black ? COLOR_BIT : 0);
+        }
+    };
+
+    std::vector<Node> nodes;
+    uint32_t root, freeList = NIL;
+    size_t count = 0;
+
+    // Erased nodes are chained through child[L] and reused first
+    uint32_t allocate(const T &value, uint32_t parent, Color color) {
+        count++;
+        if (freeList != NIL) {
+            uint32_t v = freeList;
+            freeList = nodes[v].child[Relation::L];
+            nodes[v] = Node(value, parent, color);
+            return v;
         }
 
-        const Node *nearest(int direction) const {
-            if (child[direction]) {
-                const Node *v = child[direction];
-                while (v->child[direction ^ 1]) v = v->child[direction ^ 1];
-                return v;
+        if (nodes.size() >= NIL) throw std::length_error("too many nodes");
+        nodes.emplace_back(value, parent, color);
+        return nodes.size() - 1;
+    }
+
+    void deallocate(uint32_t v) {
+        count--;
+        nodes[v].child[Relation::L] = freeList;
+        freeList = v;
+    }
+
+    Color colorOf(uint32_t v) const {
+        return v == NIL ? Color::Black : nodes[v].color();
+    }
+
+    uint32_t sizeOf(uint32_t v) const {
+        return v == NIL ? 0 : nodes[v].size;
+    }
+
+    // The black height seen through child v, a NIL child counts as 1
+    uint32_t blackHeightOf(uint32_t v) const {
+        return v == NIL ? 1 : nodes[v].blackHeight + (nodes[v].color() == Color::Black);
+    }
+
+    // While erasing, the side missing a black node is lower, so take the higher side to keep the old value
+    // until the fix up changes it
+    void calcBlackHeight(uint32_t v) {
+        Node &node = nodes[v];
+        node.blackHeight = std::max(blackHeightOf(node.child[Relation::L]), blackHeightOf(node.child[Relation::R]));
+    }
+
+    Relation which(uint32_t v) const {
+        assert(nodes[v].parent() != NIL);
+        return v == nodes[nodes[v].parent()].child[Relation::R] ? Relation::R : Relation::L;
+    }
+
+    uint32_t grandparent(uint32_t v) const {
+        uint32_t parent = nodes[v].parent();
+        return parent == NIL ? NIL : nodes[parent].parent();
+    }
+
+    uint32_t uncle(uint32_t v) const {
+        uint32_t g = grandparent(v);
+        return g == NIL ? NIL : nodes[g].child[which(nodes[v].parent()) ^ 1];
+    }
+
+    uint32_t nearest(uint32_t v, int direction) const {
+        if (nodes[v].child[direction] != NIL) {
+            v = nodes[v].child[direction];
+            while (nodes[v].child[direction ^ 1] != NIL) v = nodes[v].child[direction ^ 1];
+            return v;
+        } else {
+            while (nodes[v].parent() != NIL)
+                if (which(v) == (direction ^ 1)) return nodes[v].parent();
+                else v = nodes[v].parent();
+            return NIL;
+        }
+    }
+
+    void rotateUp(uint32_t v) {
+        uint32_t oldParent = nodes[v].parent(), grand = nodes[oldParent].parent();
+        Relation relation = which(v);
+
+        // self <--> grand parent
+        nodes[v].setParent(grand);
+        if (grand != NIL) nodes[grand].child[which(oldParent)] = v;
+        else if (oldParent == root) root = v; // Subtrees being joined have no parent either
+
+        // child <--> parent
+        uint32_t ch = nodes[v].child[relation ^ 1];
+        if (ch != NIL) nodes[ch].setParent(oldParent);
+        nodes[oldParent].child[relation] = ch;
+
+        // parent <--> self
+        nodes[oldParent].setParent(v);
+        nodes[v].child[relation ^ 1] = oldParent;
+
+        // Only these two subtrees changed
+        nodes[v].size = nodes[oldParent].size;
+        nodes[oldParent].size = sizeOf(nodes[oldParent].child[Relation::L]) + sizeOf(nodes[oldParent].child[Relation::R]) + 1;
+        calcBlackHeight(oldParent);
+        calcBlackHeight(v);
+    }
+
+    // Replace the subtree u with the subtree v in u's parent
+    void transplant(uint32_t u, uint32_t v) {
+        uint32_t parent = nodes[u].parent();
+        if (parent == NIL) root = v;
+        else nodes[parent].child[which(u)] = v;
+
+        if (v != NIL) nodes[v].setParent(parent);
+    }
+
+    // x (maybe NIL) under parent carries an extra black
+    void eraseFixUp(uint32_t x, uint32_t parent) {
+        while (x != root && colorOf(x) == Color::Black) {
+            int direction = x == nodes[parent].child[Relation::L] ? Relation::L : Relation::R;
+            uint32_t w = nodes[parent].child[direction ^ 1];
+
+            if (nodes[w].color() == Color::Red) {
+                nodes[w].setColor(Color::Black);
+                nodes[parent].setColor(Color::Red);
+                rotateUp(w);
+                w = nodes[parent].child[direction ^ 1];
+            }
+
+            if (colorOf(nodes[w].child[Relation::L]) == Color::Black && colorOf(nodes[w].child[Relation::R]) == Color::Black) {
+                // Both sides of parent are now one black short
+                nodes[w].setColor(Color::Red);
+                calcBlackHeight(parent);
+                x = parent;
+                parent = nodes[x].parent();
             } else {
-                const Node *v = this;
-                while (v->parent)
-                    if (v->which() == (direction ^ 1)) return v->parent;
-                    else v = v->parent;
-                return nullptr;
+                if (colorOf(nodes[w].child[direction ^ 1]) == Color::Black) {
+                    uint32_t nephew = nodes[w].child[direction];
+                    nodes[nephew].setColor(Color::Black);
+                    nodes[w].setColor(Color::Red);
+                    rotateUp(nephew);
+                    w = nephew;
+                }
+
+                nodes[w].setColor(nodes[parent].color());
+                nodes[parent].setColor(Color::Black);
+                nodes[nodes[w].child[direction ^ 1]].setColor(Color::Black);
+                rotateUp(w);
+                x = root;
             }
         }
 
-        void rotateUp() {
-            Node *oldParent = parent;
-            Relation relation = which();
+        if (x != NIL) nodes[x].setColor(Color::Black);
+    }
 
-            // self <--> grand parent
-            parent = oldParent->parent;
-            if (oldParent->parent) oldParent->parent->child[oldParent->which()] = this;
+    // The first node whose value is not less than x (or greater than x if strict)
+    uint32_t lowerBound(const T &x, bool strict) const {
+        uint32_t v = root, result = NIL;
+        while (v != NIL) {
+            if (strict ? x < nodes[v].value : !(nodes[v].value < x)) {
+                result = v;
+                v = nodes[v].child[Relation::L];
+            } else v = nodes[v].child[Relation::R];
+        }
+        return result;
+    }
 
-            // child <--> parent
-            if (child[relation ^ 1]) child[relation ^ 1]->parent = oldParent;
-            oldParent->child[relation] = child[relation ^ 1];
+    void insertFixUp(uint32_t v) {
+        if (nodes[v].parent() == NIL) {
+            nodes[v].setColor(Color::Black);
+            return;
+        }
 
-            // parent <--> self
-            oldParent->parent = this;
-            child[relation ^ 1] = oldParent;
+        uint32_t parent = nodes[v].parent();
+        if (nodes[parent].color() == Color::Black) return;
 
-            if (!parent) *root = this;
+        uint32_t u = uncle(v);
+        if (u != NIL && nodes[u].color() == Color::Red) {
+            nodes[parent].setColor(Color::Black);
+            nodes[u].setColor(Color::Black);
+            nodes[grandparent(v)].setColor(Color::Red);
+            calcBlackHeight(grandparent(v));
+            insertFixUp(grandparent(v));
+        } else {
+            uint32_t w;
+            if (which(v) != which(parent)) {
+                rotateUp(v);
+                w = v;
+            } else w = parent;
+
+            nodes[w].setColor(Color::Black);
+            nodes[nodes[w].parent()].setColor(Color::Red);
+            rotateUp(w);
         }
+    }
 
-        void validate() {
-            if (child[Relation::L]) child[Relation::L]->validate();
-            if (child[Relation::R]) child[Relation::R]->validate();
+    enum Operation {
+        Union, Intersection, Difference
+    };
 
-            if (child[Relation::L]) assert(blackHeight == child[Relation::L]->blackHeight + (child[Relation::L]->color == Color::Black));
-            if (child[Relation::R]) assert(blackHeight == child[Relation::R]->blackHeight + (child[Relation::R]->color == Color::Black));
-            if (!child[Relation::L] && !child[Relation::R]) assert(blackHeight == 1);
+    static constexpr size_t PARALLEL_THRESHOLD = 1 << 14;
 
-            if (color == Node::Red) {
-                if (child[Relation::L]) assert(child[Relation::L]->color == Node::Black);
-                if (child[Relation::R]) assert(child[Relation::R]->color == Node::Black);
-            }
+    void detach(uint32_t v) {
+        if (v != NIL) nodes[v].setParent(NIL);
+    }
+
+    // Build a perfectly balanced subtree from sorted values, only nodes at redDepth are red
+    template <typename RAIter>
+    uint32_t build(RAIter begin, RAIter end, uint32_t parent, size_t depth, size_t redDepth) {
+        if (begin == end) return NIL;
+
+        RAIter middle = begin + (end - begin) / 2;
+        uint32_t v = allocate(*middle, parent, depth == redDepth ? Color::Red : Color::Black);
+        uint32_t l = build(begin, middle, v, depth + 1, redDepth), r = build(middle + 1, end, v, depth + 1, redDepth);
+
+        nodes[v].child[Relation::L] = l;
+        nodes[v].child[Relation::R] = r;
+        nodes[v].size = end - begin;
+        calcBlackHeight(v);
+        return v;
+    }
+
+    // Join the detached trees l and r, with l < k < r, into one tree and return its root. Only the spine of the taller
+    // tree is walked down to the black height of the shorter one, so this costs O(|h(l) - h(r)|).
+    uint32_t join(uint32_t l, uint32_t k, uint32_t r) {
+        if (l != NIL) nodes[l].setColor(Color::Black);
+        if (r != NIL) nodes[r].setColor(Color::Black);
+
+        uint32_t hl = blackHeightOf(l), hr = blackHeightOf(r);
+        if (hl == hr) {
+            nodes[k].child[Relation::L] = l;
+            nodes[k].child[Relation::R] = r;
+            nodes[k].parentAndColor = NIL;
+            nodes[k].setColor(Color::Black);
+            nodes[k].blackHeight = hl;
+            nodes[k].size = sizeOf(l) + sizeOf(r) + 1;
+            if (l != NIL) nodes[l].setParent(k);
+            if (r != NIL) nodes[r].setParent(k);
+            return k;
+        }
+
+        int direction = hl > hr ? Relation::R : Relation::L;
+        uint32_t shorter = hl > hr ? r : l, h = std::min(hl, hr), parent = NIL, c = hl > hr ? l : r;
+        while (colorOf(c) != Color::Black || blackHeightOf(c) != h) {
+            nodes[c].size += sizeOf(shorter) + 1;
+            parent = c;
+            c = nodes[c].child[direction];
+        }
+
+        // k takes c's place, with c and the shorter tree as children
+        nodes[k].child[direction ^ 1] = c;
+        nodes[k].child[direction] = shorter;
+        nodes[k].parentAndColor = parent;
+        nodes[k].setColor(Color::Red);
+        nodes[k].blackHeight = h;
+        nodes[k].size = sizeOf(c) + sizeOf(shorter) + 1;
+        nodes[parent].child[direction] = k;
+        if (c != NIL) nodes[c].setParent(k);
+        if (shorter != NIL) nodes[shorter].setParent(k);
+
+        insertFixUp(k);
+        while (nodes[k].parent() != NIL) k = nodes[k].parent();
+        return k;
+    }
+
+    // Split the detached tree v into values less than x, a node with value x (or NIL) and values greater than x
+    void split(uint32_t v, const T &x, uint32_t &l, uint32_t &m, uint32_t &r) {
+        if (v == NIL) {
+            l = m = r = NIL;
+            return;
+        }
+
+        uint32_t a = nodes[v].child[Relation::L], b = nodes[v].child[Relation::R];
+        detach(a);
+        detach(b);
+
+        if (x < nodes[v].value) {
+            split(a, x, l, m, r);
+            r = join(r, v, b);
+        } else if (nodes[v].value < x) {
+            split(b, x, l, m, r);
+            l = join(a, v, l);
+        } else {
+            l = a;
+            m = v;
+            r = b;
+        }
+    }
+
+    // Take the maximum node out of the detached tree v
+    void splitLast(uint32_t v, uint32_t &rest, uint32_t &last) {
+        uint32_t a = nodes[v].child[Relation::L], b = nodes[v].child[Relation::R];
+        detach(a);
+        detach(b);
+
+        if (b == NIL) {
+            rest = a;
+            last = v;
+        } else {
+            splitLast(b, rest, last);
+            rest = join(a, v, rest);
+        }
+    }
+
+    uint32_t join2(uint32_t l, uint32_t r) {
+        if (l == NIL) return r;
+        if (r == NIL) return l;
+
+        uint32_t rest, last;
+        splitLast(l, rest, last);
+        return join(rest, last, r);
+    }
+
+    // Split b by a's root and combine the halves recursively, forking while there are levels of parallelism left.
+    // The two halves touch disjoint nodes of the arena.
+    uint32_t combine(uint32_t a, uint32_t b, Operation operation, size_t parallelLevels) {
+        if (a == NIL) return operation == Operation::Union ? b : NIL;
+        if (b == NIL) return operation == Operation::Intersection ? NIL : a;
+
+        bool parallel = parallelLevels > 0 && sizeOf(a) + sizeOf(b) >= PARALLEL_THRESHOLD;
+
+        uint32_t la = nodes[a].child[Relation::L], ra = nodes[a].child[Relation::R];
+        detach(la);
+        detach(ra);
+
+        uint32_t lb, m, rb;
+        split(b, nodes[a].value, lb, m, rb);
+
+        uint32_t l, r;
+        if (parallel) {
+            std::thread thread([&]() {
+                l = combine(la, lb, operation, parallelLevels - 1);
+            });
+            r = combine(ra, rb, operation, parallelLevels - 1);
+            thread.join();
+        } else {
+            l = combine(la, lb, operation, 0);
+            r = combine(ra, rb, operation, 0);
+        }
+
+        bool keep = operation == Operation::Union || (operation == Operation::Intersection) == (m != NIL);
+        return keep ? join(l, a, r) : join2(l, r);
+    }
+
+    // Run a set operation on copies of both arenas placed side by side, then free the nodes that were dropped
+    static RedBlackTree combine(const RedBlackTree &a, const RedBlackTree &b, Operation operation, size_t threads) {
+        if (a.nodes.size() + b.nodes.size() >= NIL) throw std::length_error("too many nodes");
+
+        RedBlackTree result;
+        result.nodes.reserve(a.nodes.size() + b.nodes.size());
+        result.nodes = a.nodes;
+
+        uint32_t offset = a.nodes.size();
+        auto rebase = [&](uint32_t v) {
+            return v == NIL ? NIL : v + offset;
+        };
+        for (Node node : b.nodes) {
+            node.child[Relation::L] = rebase(node.child[Relation::L]);
+            node.child[Relation::R] = rebase(node.child[Relation::R]);
+            node.setParent(rebase(node.parent()));
+            result.nodes.push_back(node);
         }
-    } *root;
 
-    const Node *find(const T &x) const {
-        const Node *v = root;
-        while (v && x != v->value) v = v->child[!(x < v->value)];
+        size_t parallelLevels = 0;
+        while ((size_t(1) << parallelLevels) < threads) parallelLevels++;
+
+        uint32_t root = result.combine(a.root, rebase(b.root), operation, parallelLevels);
+        if (root != NIL) {
+            result.nodes[root].setParent(NIL);
+            result.nodes[root].setColor(Color::Black);
+        }
+        result.root = root;
+
+        std::vector<bool> used(result.nodes.size());
+        std::vector<uint32_t> stack;
+        if (root != NIL) stack.push_back(root);
+        while (!stack.empty()) {
+            uint32_t v = stack.back();
+            stack.pop_back();
+            used[v] = true;
+            for (uint32_t ch : result.nodes[v].child) if (ch != NIL) stack.push_back(ch);
+        }
+
+        result.count = result.nodes.size();
+        for (uint32_t v = result.nodes.size(); v-- > 0;) if (!used[v]) result.deallocate(v);
+
+        return result;
+    }
+
+    uint32_t find(const T &x) const {
+        uint32_t v = root;
+        while (v != NIL && x != nodes[v].value) v = nodes[v].child[!(x < nodes[v].value)];
         return v;
     }
 
+    void validate(uint32_t v) const {
+        const Node &node = nodes[v];
+        for (uint32_t ch : node.child) {
+            assert(node.blackHeight == blackHeightOf(ch));
+            if (ch == NIL) continue;
+
+            validate(ch);
+            assert(nodes[ch].parent() == v);
+            if (node.color() == Color::Red) assert(nodes[ch].color() == Color::Black);
+        }
+
+        assert(node.size == sizeOf(node.child[Relation::L]) + sizeOf(node.child[Relation::R]) + 1);
+    }
+
 public:
-    RedBlackTree() : root(nullptr) {}
+    class iterator {
+        friend RedBlackTree;
+
+        const RedBlackTree *tree;
+        uint32_t v;
+
+        iterator(const RedBlackTree *tree, uint32_t v) : tree(tree), v(v) {}
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T *;
+        using reference = const T &;
+
+        iterator() : iterator(nullptr, NIL) {}
+
+        const T &operator*() const {
+            return tree->nodes[v].value;
+        }
+
+        const T *operator->() const {
+            return &tree->nodes[v].value;
+        }
+
+        iterator &operator++() {
+            v = tree->nearest(v, 1);
+            return *this;
+        }
+
+        // Decrementing end() gives the maximum
+        iterator &operator--() {
+            if (v != NIL) v = tree->nearest(v, 0);
+            else for (v = tree->root; tree->nodes[v].child[Relation::R] != NIL; v = tree->nodes[v].child[Relation::R]);
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        iterator operator--(int) {
+            iterator old = *this;
+            --*this;
+            return old;
+        }
+
+        bool operator==(const iterator &other) const {
+            return v == other.v;
+        }
+
+        bool operator!=(const iterator &other) const {
+            return v != other.v;
+        }
+    };
+
+    RedBlackTree() : root(NIL) {}
+
+    // Build from sorted values in O(n)
+    template <typename RAIter>
+    RedBlackTree(RAIter begin, RAIter end) : root(NIL) {
+        assert(std::is_sorted(begin, end));
+
+        size_t n = end - begin, redDepth = 0;
+        while ((size_t(2) << redDepth) <= n + 1) redDepth++;
+
+        if (n >= NIL) throw std::length_error("too many nodes");
+        nodes.reserve(n);
+        root = build(begin, end, NIL, 0, redDepth);
+    }
+
+    // Set operations by split and join, values are assumed distinct in each tree
+    static RedBlackTree unionOf(const RedBlackTree &a, const RedBlackTree &b,
+                                size_t threads = std::thread::hardware_concurrency()) {
+        return combine(a, b, Operation::Union, threads);
+    }
+
+    static RedBlackTree intersectionOf(const RedBlackTree &a, const RedBlackTree &b,
+                                       size_t threads = std::thread::hardware_concurrency()) {
+        return combine(a, b, Operation::Intersection, threads);
+    }
+
+    static RedBlackTree differenceOf(const RedBlackTree &a, const RedBlackTree &b,
+                                     size_t threads = std::thread::hardware_concurrency()) {
+        return combine(a, b, Operation::Difference, threads);
+    }
+
+    iterator begin() const {
+        uint32_t v = root;
+        while (v != NIL && nodes[v].child[Relation::L] != NIL) v = nodes[v].child[Relation::L];
+        return iterator(this, v);
+    }
+
+    iterator end() const {
+        return iterator(this, NIL);
+    }
+
+    iterator lower_bound(const T &x) const {
+        return iterator(this, lowerBound(x, false));
+    }
+
+    iterator upper_bound(const T &x) const {
+        return iterator(this, lowerBound(x, true));
+    }
+
+    // Call f for every value in [lo, hi) in order, with one search for lo and then in-order steps
+    template <typename Function>
+    void rangeScan(const T &lo, const T &hi, Function f) const {
+        for (uint32_t v = lowerBound(lo, false); v != NIL && nodes[v].value < hi; v = nearest(v, 1)) f(nodes[v].value);
+    }
+
+    void reserve(size_t n) {
+        nodes.reserve(n);
+    }
 
     void insert(const T &x) {
-        Node **p = &root, *parent = nullptr;
-        while (Node *v = *p) {
+        uint32_t parent = NIL;
+        int relation = Relation::L;
+        for (uint32_t v = root; v != NIL; v = nodes[v].child[relation]) {
+            nodes[v].size++;
             parent = v;
-            p = &v->child[!(x < v->value)];
+            relation = !(x < nodes[v].value);
         }
-        *p = new Node(x, parent, Node::Color::Red, &root);
 
-        insertFixUp(*p);
-        for (Node *v = *p; v; v = v->parent) v->calcBlackHeight();
+        // A red leaf doesn't change any black height
+        uint32_t v = allocate(x, parent, Color::Red);
+        if (parent == NIL) root = v;
+        else nodes[parent].child[relation] = v;
+
+        insertFixUp(v);
     }
 
-    void insertFixUp(Node *v) {
-        if (v == root) {
-            v->color = Node::Color::Black;
-            return;
-        }
+    // Remove one node with value x, return whether there was one
+    bool erase(const T &x) {
+        uint32_t z = find(x);
+        if (z == NIL) return false;
 
-        if (v->parent->color == Node::Color::Black) return;
+        uint32_t y = z, child, parent;
+        Color erasedColor = nodes[y].color();
+        bool hasTwoChildren = nodes[z].child[Relation::L] != NIL && nodes[z].child[Relation::R] != NIL;
+        for (uint32_t v = nodes[hasTwoChildren ? nearest(z, 1) : z].parent(); v != NIL; v = nodes[v].parent()) nodes[v].size--;
 
-        Node *uncle = v->uncle();
-        if (uncle && uncle->color == Node::Color::Red) {
-            v->parent->color = Node::Color::Black;
-            uncle->color = Node::Color::Black;
-            v->grandparent()->color = Node::Color::Red;
-            insertFixUp(v->grandparent());
+        if (!hasTwoChildren) {
+            child = nodes[z].child[nodes[z].child[Relation::L] == NIL ? Relation::R : Relation::L];
+            parent = nodes[z].parent();
+            transplant(z, child);
         } else {
-            Node *u;
-            if (v->which() != v->parent->which()) {
-                v->rotateUp();
-                u = v;
-            } else u = v->parent;
+            // Move z's successor y into z's place
+            y = nearest(z, 1);
+            erasedColor = nodes[y].color();
+            child = nodes[y].child[Relation::R];
+
+            if (nodes[y].parent() == z) parent = y;
+            else {
+                parent = nodes[y].parent();
+                transplant(y, child);
+                nodes[y].child[Relation::R] = nodes[z].child[Relation::R];
+                nodes[nodes[y].child[Relation::R]].setParent(y);
+            }
 
-            u->color = Node::Color::Black;
-            u->parent->color = Node::Color::Red;
-            u->rotateUp();
+            transplant(z, y);
+            nodes[y].child[Relation::L] = nodes[z].child[Relation::L];
+            nodes[nodes[y].child[Relation::L]].setParent(y);
+            nodes[y].setColor(nodes[z].color());
+            nodes[y].blackHeight = nodes[z].blackHeight;
+            nodes[y].size = nodes[z].size;
         }
+
+        deallocate(z);
+        if (erasedColor == Color::Black) eraseFixUp(child, parent);
+
+        return true;
     }
 
+    // The greatest value less than x
     const T *predecessor(const T &x) const {
-        const Node *v = find(x);
-        if (!v) return nullptr;
-
-        const Node *u = v->nearest(0);
-        return u ? &u->value : nullptr;
+        uint32_t v = root, result = NIL;
+        while (v != NIL) {
+            if (nodes[v].value < x) {
+                result = v;
+                v = nodes[v].child[Relation::R];
+            } else v = nodes[v].child[Relation::L];
+        }
+        return result != NIL ? &nodes[result].value : nullptr;
     }
 
+    // The least value greater than x
     const T *successor(const T &x) const {
-        const Node *v = find(x);
-        if (!v) return nullptr;
+        uint32_t v = lowerBound(x, true);
+        return v != NIL ? &nodes[v].value : nullptr;
+    }
 
-        const Node *u = v->nearest(1);
-        return u ? &u->value : nullptr;
+    // The number of values less than x
+    size_t rank(const T &x) const {
+        size_t result = 0;
+        for (uint32_t v = root; v != NIL;) {
+            if (nodes[v].value < x) {
+                result += sizeOf(nodes[v].child[Relation::L]) + 1;
+                v = nodes[v].child[Relation::R];
+            } else v = nodes[v].child[Relation::L];
+        }
+        return result;
+    }
+
+    // The k-th (0-based) smallest value
+    const T *select(size_t k) const {
+        if (k >= size()) return nullptr;
+
+        uint32_t v = root;
+        while (true) {
+            size_t leftSize = sizeOf(nodes[v].child[Relation::L]);
+            if (k == leftSize) return &nodes[v].value;
+            else if (k < leftSize) v = nodes[v].child[Relation::L];
+            else {
+                k -= leftSize + 1;
+                v = nodes[v].child[Relation::R];
+            }
+        }
     }
 
     const T *minimum() const {
-        const Node *v = root;
-        while (v && v->child[Relation::L]) v = v->child[Relation::L];
-        return v ? &v->value : nullptr;
+        uint32_t v = root;
+        while (v != NIL && nodes[v].child[Relation::L] != NIL) v = nodes[v].child[Relation::L];
+        return v != NIL ? &nodes[v].value : nullptr;
     }
 
     const T *maximum() const {
-        const Node *v = root;
-        while (v && v->child[Relation::R]) v = v->child[Relation::R];
-        return v ? &v->value : nullptr;
+        uint32_t v = root;
+        while (v != NIL && nodes[v].child[Relation::R] != NIL) v = nodes[v].child[Relation::R];
+        return v != NIL ? &nodes[v].value : nullptr;
+    }
+
+    size_t size() const {
+        return count;
     }
 
     void validate() const {
-        if (root) root->validate();
+        if (root != NIL) {
+            assert(nodes[root].color() == Color::Black);
+            validate(root);
+        }
     }
 };
 
@@ -203,6 +733,16 @@ int main() {
         tree.validate();
     });
 
+    BPlusTree<uint64_t> bPlusTree;
+
+    measureTime("Insert data into B+ tree", [&]() {
+        for (auto x : data) bPlusTree.insert(x);
+    });
+
+    measureTime("Validate B+ tree", [&]() {
+        bPlusTree.validate();
+    });
+
     std::sort(data.begin(), data.end());
     measureTime("Find predecessor and successor (for all elements)", [&]() {
         for (size_t i = 1; i < data.size(); i++) {
@@ -214,8 +754,139 @@ int main() {
         }
     });
 
+    measureTime("Find predecessor and successor with B+ tree (for all elements)", [&]() {
+        for (size_t i = 1; i < data.size(); i++) {
+            assert(*bPlusTree.predecessor(data[i]) == data[i - 1]);
+        }
+
+        for (size_t i = 0; i < data.size() - 1; i++) {
+            assert(*bPlusTree.successor(data[i]) == data[i + 1]);
+        }
+    });
+
     measureTime("Find minimum and maximum", [&]() {
         assert(*tree.minimum() == data.front());
         assert(*tree.maximum() == data.back());
+        assert(*bPlusTree.minimum() == data.front());
+        assert(*bPlusTree.maximum() == data.back());
+    });
+
+    measureTime("Build tree from sorted data", [&]() {
+        RedBlackTree<uint64_t> built(data.begin(), data.end());
+        built.validate();
+        assert(built.size() == data.size() && *built.select(data.size() / 2) == data[data.size() / 2]);
+    });
+
+    // The first two thirds and the last two thirds of data
+    size_t third = data.size() / 3;
+    RedBlackTree<uint64_t> front(data.begin(), data.end() - third), back(data.begin() + third, data.end());
+    auto checkRange = [&](const RedBlackTree<uint64_t> &result, size_t l, size_t r) {
+        result.validate();
+        assert(result.size() == r - l && std::equal(result.begin(), result.end(), data.begin() + l));
+    };
+
+    measureTime("Union of trees", [&]() {
+        checkRange(RedBlackTree<uint64_t>::unionOf(front, back), 0, data.size());
+    });
+
+    measureTime("Intersection of trees", [&]() {
+        checkRange(RedBlackTree<uint64_t>::intersectionOf(front, back), third, data.size() - third);
+    });
+
+    measureTime("Difference of trees", [&]() {
+        checkRange(RedBlackTree<uint64_t>::differenceOf(front, back), 0, third);
+    });
+
+    for (size_t readers : {size_t(0), std::max<size_t>(1, std::thread::hardware_concurrency() - 1)}) {
+        std::vector<uint64_t> shuffled = data;
+        std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937_64(readers));
+
+        ConcurrentOrderedMap<uint64_t, uint64_t> map;
+        std::atomic<bool> done(false);
+        std::atomic<size_t> queries(0);
+
+        measureTime("Insert into concurrent ordered map with " + std::to_string(readers) + " readers", [&]() {
+            std::vector<std::thread> threads;
+            for (size_t t = 0; t < readers; t++) threads.emplace_back([&, t]() {
+                std::mt19937_64 rng(t);
+                size_t count = 0;
+                while (!done.load()) {
+                    // Within one snapshot the neighbours of a key agree with each other
+                    auto snapshot = map.snapshot();
+                    uint64_t x = data[rng() % data.size()];
+                    auto predecessor = snapshot.predecessor(x), successor = snapshot.successor(x);
+                    if (predecessor && successor) assert(snapshot.successor(predecessor->first)->first == (snapshot.find(x) ? x : successor->first));
+                    count++;
+                }
+                queries += count;
+            });
+
+            for (auto x : shuffled) map.insert(x, ~x);
+            done = true;
+            for (auto &thread : threads) thread.join();
+        });
+        if (readers) std::cerr << queries << " queries while inserting" << std::endl;
+
+        measureTime("Find predecessor and successor with concurrent ordered map (for all elements)", [&]() {
+            auto snapshot = map.snapshot();
+            for (size_t i = 1; i < data.size(); i++) assert(snapshot.predecessor(data[i])->first == data[i - 1]);
+            for (size_t i = 0; i < data.size() - 1; i++) assert(snapshot.successor(data[i])->second == ~data[i + 1]);
+            assert(map.size() == data.size());
+        });
+    }
+
+    measureTime("Rank and select (for all elements)", [&]() {
+        for (size_t i = 0; i < data.size(); i++) {
+            assert(tree.rank(data[i]) == i);
+            assert(*tree.select(i) == data[i]);
+        }
+    });
+
+    measureTime("Iterate over the tree", [&]() {
+        size_t i = 0;
+        for (auto x : tree) assert(x == data[i++]);
+        assert(i == data.size());
+    });
+
+    measureTime("Range scan (1000 ranges)", [&]() {
+        for (size_t i = 0; i < 1000; i++) {
+            size_t l = data.size() / 1000 * i, r = std::min(l + 500, data.size() - 1);
+            size_t j = l;
+            tree.rangeScan(data[l], data[r], [&](uint64_t x) {
+                assert(x == data[j++]);
+            });
+            assert(j == r);
+        }
+    });
+
+    measureTime("Range scan with B+ tree (1000 ranges)", [&]() {
+        for (size_t i = 0; i < 1000; i++) {
+            size_t l = data.size() / 1000 * i, r = std::min(l + 500, data.size() - 1);
+            size_t j = l;
+            bPlusTree.rangeScan(data[l], data[r], [&](uint64_t x) {
+                assert(x == data[j++]);
+            });
+            assert(j == r);
+        }
+    });
+
+    measureTime("Erase half of data from tree", [&]() {
+        for (size_t i = 0; i < data.size(); i += 2) tree.erase(data[i]);
+    });
+
+    measureTime("Validate tree", [&]() {
+        tree.validate();
+    });
+
+    measureTime("Percentiles after erasing", [&]() {
+        for (size_t p = 0; p < 100; p++) assert(*tree.select(tree.size() * p / 100) == data[tree.size() * p / 100 * 2 + 1]);
+    });
+
+    measureTime("Lower bound and upper bound (for all elements)", [&]() {
+        // Only the odd positions are left
+        for (size_t i = 0; i + 2 < data.size(); i++) {
+            assert(*tree.lower_bound(data[i]) == data[i % 2 ? i : i + 1]);
+            assert(*tree.upper_bound(data[i]) == data[i % 2 ? i + 2 : i + 1]);
+        }
     });
 }
@@ -2,58 +2,245 @@
 #include <limits>
 #include <algorithm>
 #include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
 
-const int MAXN = 1000;
+// Reads integers from a FILE through a large buffer
+class FastReader {
+    static const size_t BUFFER_SIZE = 1 << 16;
 
-struct Node {
-    std::vector<struct Edge> edges;
-    bool visited;
-} nodes[MAXN + 1];
+    FILE *file;
+    char buffer[BUFFER_SIZE];
+    size_t size = 0, position = 0;
 
-struct Edge {
-    Node &from, &to;
-    int weight;
+    int getChar() {
+        if (position == size) {
+            size = fread(buffer, 1, BUFFER_SIZE, file);
+            position = 0;
+            if (size == 0) return EOF;
+        }
+        return buffer[position++];
+    }
+
+public:
+    FastReader(FILE *file) : file(file) {}
+
+    template <typename T>
+    bool read(T &x) {
+        int c = getChar();
+        while (c != EOF && c != '-' && (c < '0' || c > '9')) c = getChar();
+        if (c == EOF) return false;
+
+        bool negative = c == '-';
+        if (negative) c = getChar();
+
+        for (x = 0; c >= '0' && c <= '9'; c = getChar()) x = x * 10 + (c - '0');
+        if (negative) x = -x;
+        return true;
+    }
 };
 
-inline void addEdge(int from, int to, int weight) {
-    nodes[from].edges.push_back(Edge{nodes[from], nodes[to], weight});
-    nodes[to].edges.push_back(Edge{nodes[to], nodes[from], weight});
-}
+// An undirected weighted tree with nodes 1 to n, stored as CSR: the neighbors of v are to[offset[v], offset[v + 1])
+class Tree {
+    std::vector<uint32_t> offset, to;
+    std::vector<int> weight;
 
-inline int dfs(Node &v) {
-    v.visited = true;
+    // After root(r): every node comes after its parent in order
+    std::vector<uint32_t> order, parent, stack;
 
-    int sum = 0;
-    bool isLeaf = true;
-    for (Edge &e : v.edges) {
-        if (!e.to.visited) {
-            sum += std::min(dfs(e.to), e.weight);
+public:
+    size_t n;
 
-            isLeaf = false;
+    void build(size_t n, const std::vector<uint32_t> &from, const std::vector<uint32_t> &to, const std::vector<int> &weight) {
+        this->n = n;
+
+        // Count degrees into offset[v + 1], take prefix sums to get the starts, fill by bumping the starts to the ends,
+        // then shift them back
+        offset.assign(n + 2, 0);
+        for (size_t i = 0; i < from.size(); i++) offset[from[i] + 1]++, offset[to[i] + 1]++;
+        for (size_t v = 1; v <= n + 1; v++) offset[v] += offset[v - 1];
+
+        this->to.resize(from.size() * 2);
+        this->weight.resize(from.size() * 2);
+        for (size_t i = 0; i < from.size(); i++) {
+            uint32_t p = offset[from[i]]++, q = offset[to[i]]++;
+            this->to[p] = to[i], this->weight[p] = weight[i];
+            this->to[q] = from[i], this->weight[q] = weight[i];
         }
+        for (size_t v = n + 1; v > 0; v--) offset[v] = offset[v - 1];
+        offset[0] = 0;
+    }
+
+    // Depth-first order from root with an explicit stack
+    void root(uint32_t r) {
+        order.clear();
+        parent.assign(n + 1, 0);
+        stack.assign(1, r);
+        while (!stack.empty()) {
+            uint32_t v = stack.back();
+            stack.pop_back();
+            order.push_back(v);
+
+            for (uint32_t i = offset[v]; i < offset[v + 1]; i++)
+                if (to[i] != parent[v]) {
+                    parent[to[i]] = v;
+                    stack.push_back(to[i]);
+                }
+        }
+    }
+
+    // Call f(v) for every node after all its children, f(v) can go through the children with forEachChild
+    template <typename Function>
+    void postOrder(Function f) const {
+        for (size_t i = order.size(); i-- > 0;) f(order[i]);
+    }
+
+    // Call f(v) for every node after its parent
+    template <typename Function>
+    void preOrder(Function f) const {
+        for (uint32_t v : order) f(v);
+    }
+
+    size_t degree(uint32_t v) const {
+        return offset[v + 1] - offset[v];
+    }
+
+    // Call f(child, weight) for each child of v
+    template <typename Function>
+    void forEachChild(uint32_t v, Function f) const {
+        for (uint32_t i = offset[v]; i < offset[v + 1]; i++)
+            if (to[i] != parent[v]) f(to[i], weight[i]);
     }
+};
+
+const long long INF = std::numeric_limits<long long>::max();
+
+// The minimum total weight of edges to cut to separate root from all leaves
+long long minCut(Tree &tree, uint32_t root, std::vector<long long> &dp) {
+    tree.root(root);
+    dp.resize(tree.n + 1);
+
+    tree.postOrder([&](uint32_t v) {
+        long long sum = 0;
+        bool isLeaf = true;
+        tree.forEachChild(v, [&](uint32_t ch, int weight) {
+            sum += std::min(dp[ch], (long long)weight);
+            isLeaf = false;
+        });
+
+        dp[v] = isLeaf ? INF : sum;
+    });
 
-    if (isLeaf) return std::numeric_limits<int>::max();
+    return dp[root] == INF ? 0 : dp[root];
+}
+
+// minCut for every root in O(n) total by rerooting: with the values rooted at 1, the parent side of a child is its
+// parent's total minus the child's own term, unless the parent has no other neighbor and so becomes a leaf
+void minCutAllRoots(Tree &tree, std::vector<long long> &dp, std::vector<long long> &answers) {
+    minCut(tree, 1, dp);
+    answers.resize(tree.n + 1);
+
+    // Before v is visited answers[v] holds the term of its parent side
+    answers[1] = 0;
+    tree.preOrder([&](uint32_t v) {
+        long long total = (dp[v] == INF ? 0 : dp[v]) + answers[v];
+        answers[v] = total;
 
-    return sum;
+        tree.forEachChild(v, [&](uint32_t ch, int weight) {
+            long long up = tree.degree(v) == 1 ? INF : total - std::min(dp[ch], (long long)weight);
+            answers[ch] = std::min(up, (long long)weight);
+        });
+    });
 }
 
-int main() {
-    for (int n, root; (std::cin >> n >> root) && n; ) {
-        for (int i = 0; i < n - 1; i++) {
-            int u, v, w;
-            std::cin >> u >> v >> w;
-            addEdge(u, v, w);
+struct TestCase {
+    size_t n;
+    uint32_t root;
+    std::vector<uint32_t> from, to;
+    std::vector<int> weight;
+    std::vector<long long> answers;
+};
+
+// Solve independent test cases on the given number of threads, each with its own buffers
+void solve(std::vector<TestCase> &cases, size_t threads, bool allRoots) {
+    auto worker = [&](size_t t) {
+        Tree tree;
+        std::vector<long long> dp;
+        for (size_t i = t; i < cases.size(); i += threads) {
+            TestCase &c = cases[i];
+            tree.build(c.n, c.from, c.to, c.weight);
+
+            // The edge list isn't needed once it's in the CSR, free it before the DP allocates its buffers
+            std::vector<uint32_t>().swap(c.from);
+            std::vector<uint32_t>().swap(c.to);
+            std::vector<int>().swap(c.weight);
+
+            if (allRoots) minCutAllRoots(tree, dp, c.answers);
+            else c.answers.assign(1, minCut(tree, c.root, dp));
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threads; t++) workers.emplace_back(worker, t);
+    worker(0);
+    for (auto &thread : workers) thread.join();
+}
+
+// Usage: TreeCut [--all-roots] [--threads N]
+// Test cases are read and solved in batches, so a huge tree is still solved alone
+int main(int argc, char *argv[]) {
+    bool allRoots = false;
+    size_t threads = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--all-roots") == 0) allRoots = true;
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = std::stoul(argv[++i]);
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--all-roots] [--threads N]" << std::endl;
+            return 1;
         }
+    }
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
 
-        int ans = dfs(nodes[root]);
-        if (ans == std::numeric_limits<int>::max()) ans = 0;
+    const size_t BATCH_CASES = 4096, BATCH_NODES = 1 << 22;
+
+    FastReader reader(stdin);
+    std::ios::sync_with_stdio(false);
+
+    std::vector<TestCase> cases;
+    for (bool end = false; !end; ) {
+        size_t count = 0, nodes = 0;
+        for (size_t n; count < BATCH_CASES && nodes < BATCH_NODES; ) {
+            if (!reader.read(n) || n == 0) {
+                end = true;
+                break;
+            }
+
+            if (cases.size() <= count) cases.emplace_back();
+            TestCase &c = cases[count++];
+            c.n = n;
+            c.root = 1;
+            reader.read(c.root);
+
+            c.from.resize(n - 1);
+            c.to.resize(n - 1);
+            c.weight.resize(n - 1);
+            for (size_t i = 0; i < n - 1; i++) {
+                reader.read(c.from[i]);
+                reader.read(c.to[i]);
+                reader.read(c.weight[i]);
+            }
+            nodes += n;
+        }
 
-        std::cout << ans << std::endl;
+        cases.resize(count);
+        solve(cases, std::min(threads, std::max<size_t>(count, 1)), allRoots);
 
-        for (int i = 1; i <= MAXN; i++) {
-            nodes[i].visited = false;
-            nodes[i].edges.clear();
+        for (TestCase &c : cases) {
+            if (!allRoots) std::cout << c.answers[0] << '\n';
+            else for (size_t v = 1; v <= c.n; v++) std::cout << c.answers[v] << (v == c.n ? '\n' : ' ');
         }
     }
 }
@@ -1,16 +1,411 @@
 #include <iostream>
 #include <algorithm>
+#include <limits>
+#include <vector>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <fstream>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
 
-int main() {
-	for (int n; std::cin >> n, n != 0; ) {
-		int min = std::numeric_limits<int>::max(), ans = 0;
-		for (int i = 0; i < n; i++) {
-			int x;
-			std::cin >> x;
-			min = std::min(min, x);
-			ans = std::max(ans, x - min);
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// The best single buy-then-sell profit of a chunk of prices, with its minimum and maximum so chunks can be combined
+struct Summary {
+	int32_t min, max;
+	int64_t best;
+};
+
+const Summary EMPTY_SUMMARY = {std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::min(), 0};
+
+// a followed by b
+Summary combine(const Summary &a, const Summary &b) {
+	int64_t across = b.max >= a.min ? (int64_t)b.max - a.min : 0;
+	return {std::min(a.min, b.min), std::max(a.max, b.max), std::max({a.best, b.best, across})};
+}
+
+Summary summarizeScalar(const int32_t *prices, size_t n, Summary summary = EMPTY_SUMMARY) {
+	for (size_t i = 0; i < n; i++) {
+		summary.min = std::min(summary.min, prices[i]);
+		summary.max = std::max(summary.max, prices[i]);
+		summary.best = std::max(summary.best, (int64_t)prices[i] - summary.min);
+	}
+	return summary;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// Scan blocks of 8 prices: the prefix minimum inside a block takes three shift-and-min steps, then the minimum carried
+// from previous blocks is applied to the whole block. A price minus a prefix minimum including itself is never
+// negative, so the differences are compared as unsigned 32-bit numbers and can't overflow.
+__attribute__((target("avx2")))
+Summary summarizeAVX2(const int32_t *prices, size_t n) {
+	const int32_t MAX = std::numeric_limits<int32_t>::max(), MIN = std::numeric_limits<int32_t>::min();
+	const __m256i shiftIndex[3] = {
+		_mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6),
+		_mm256_setr_epi32(0, 0, 0, 1, 2, 3, 4, 5),
+		_mm256_setr_epi32(0, 0, 0, 0, 0, 1, 2, 3)
+	};
+	const __m256i shiftFill[3] = {
+		_mm256_setr_epi32(MAX, MIN, MIN, MIN, MIN, MIN, MIN, MIN),
+		_mm256_setr_epi32(MAX, MAX, MIN, MIN, MIN, MIN, MIN, MIN),
+		_mm256_setr_epi32(MAX, MAX, MAX, MAX, MIN, MIN, MIN, MIN)
+	};
+
+	size_t i = 0;
+	__m256i carry = _mm256_set1_epi32(MAX), best = _mm256_setzero_si256(), max = _mm256_set1_epi32(MIN);
+	for (; i + 8 <= n; i += 8) {
+		__m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(prices + i)), prefixMin = x;
+		for (int s = 0; s < 3; s++) {
+			__m256i shifted = _mm256_max_epi32(_mm256_permutevar8x32_epi32(prefixMin, shiftIndex[s]), shiftFill[s]);
+			prefixMin = _mm256_min_epi32(prefixMin, shifted);
+		}
+		prefixMin = _mm256_min_epi32(prefixMin, carry);
+
+		best = _mm256_max_epu32(best, _mm256_sub_epi32(x, prefixMin));
+		max = _mm256_max_epi32(max, x);
+		carry = _mm256_permutevar8x32_epi32(prefixMin, _mm256_set1_epi32(7));
+	}
+
+	Summary summary = EMPTY_SUMMARY;
+	alignas(32) uint32_t bestLanes[8];
+	alignas(32) int32_t maxLanes[8];
+	_mm256_store_si256(reinterpret_cast<__m256i *>(bestLanes), best);
+	_mm256_store_si256(reinterpret_cast<__m256i *>(maxLanes), max);
+	if (i > 0) {
+		summary.min = _mm256_extract_epi32(carry, 0);
+		summary.max = *std::max_element(maxLanes, maxLanes + 8);
+		summary.best = *std::max_element(bestLanes, bestLanes + 8);
+	}
+	return summarizeScalar(prices + i, n - i, summary);
+}
+#endif
+
+// The AVX2 scan is chosen at run time, so it's used without building for AVX2
+Summary summarize(const int32_t *prices, size_t n) {
+#if defined(__x86_64__) || defined(__i386__)
+	static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+	if (hasAVX2) return summarizeAVX2(prices, n);
+#endif
+	return summarizeScalar(prices, n);
+}
+
+// Below NONE / 2 a state can't be reached, the margin keeps sums of such states from overflowing
+const int64_t NONE = std::numeric_limits<int64_t>::min() / 4;
+
+// Feed prices to the states of at most K transactions, each paying fee when sold. cash[j] and hold[j] are the best
+// cash not holding or holding a share after j buys. Going down from j = K, the states of j are updated before the
+// states of j - 1 they're computed from, so they always see the previous price. With unlimited transactions only
+// j = 0 is used.
+void advanceScalar(const int32_t *prices, size_t n, size_t K, bool unlimited, int64_t fee, int64_t *cash, int64_t *hold) {
+	if (unlimited) {
+		int64_t c = cash[0], h = hold[0];
+		for (size_t i = 0; i < n; i++) {
+			h = std::max(h, c - prices[i]);
+			c = std::max(c, h + prices[i] - fee);
+		}
+		cash[0] = c, hold[0] = h;
+		return;
+	}
+
+	for (size_t i = 0; i < n; i++) {
+		int64_t price = prices[i];
+		for (size_t j = K; j >= 1; j--) {
+			cash[j] = std::max(cash[j], hold[j] + price - fee);
+			hold[j] = std::max(hold[j], cash[j - 1] - price);
+		}
+		cash[0] = std::max(cash[0], hold[0] + price - fee);
+	}
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+inline __m256i max64(__m256i a, __m256i b) {
+	return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(b, a));
+}
+
+// The same in blocks of 4 states (j - 4, j], going down from j = K. The block also needs the old cash[j - 4] from the
+// block below, which is loaded first and shifted in, so every load matches an earlier store and can be forwarded.
+__attribute__((target("avx2")))
+void advanceAVX2(const int32_t *prices, size_t n, size_t K, int64_t fee, int64_t *cash, int64_t *hold) {
+	for (size_t i = 0; i < n; i++) {
+		int64_t price = prices[i];
+		__m256i sell = _mm256_set1_epi64x(price - fee), buy = _mm256_set1_epi64x(price);
+
+		size_t j = K;
+		__m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cash + j - 3));
+		for (; j >= 4; j -= 4) {
+			__m256i below = j >= 8 ? _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cash + j - 7)) : _mm256_set1_epi64x(cash[j - 4]);
+			__m256i previous = _mm256_alignr_epi8(c, _mm256_permute2x128_si256(below, c, 0x21), 8);
+			__m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(hold + j - 3));
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(cash + j - 3), max64(c, _mm256_add_epi64(h, sell)));
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(hold + j - 3), max64(h, _mm256_sub_epi64(previous, buy)));
+			c = below;
+		}
+		for (; j >= 1; j--) {
+			cash[j] = std::max(cash[j], hold[j] + price - fee);
+			hold[j] = std::max(hold[j], cash[j - 1] - price);
+		}
+		cash[0] = std::max(cash[0], hold[0] + price - fee);
+	}
+}
+#endif
+
+void advance(const int32_t *prices, size_t n, size_t K, bool unlimited, int64_t fee, int64_t *cash, int64_t *hold) {
+#if defined(__x86_64__) || defined(__i386__)
+	static const bool hasAVX2 = __builtin_cpu_supports("avx2");
+	if (hasAVX2 && !unlimited && K >= 8) return advanceAVX2(prices, n, K, fee, cash, hold);
+#endif
+	advanceScalar(prices, n, K, unlimited, fee, cash, hold);
+}
+
+// How a chunk of a series changes the states: gain[(s * 2 + e) * (K + 1) + d] is the best change of cash from
+// entering the chunk holding s shares to leaving it holding e, with d buys inside the chunk
+struct ChunkEffect {
+	std::vector<int64_t> gain;
+};
+
+// Run from a single state: not holding, or holding a share bought before the chunk
+void runFrom(bool holding, const int32_t *prices, size_t n, size_t K, bool unlimited, int64_t fee,
+             std::vector<int64_t> &cash, std::vector<int64_t> &hold) {
+	cash.assign(K + 1, NONE);
+	hold.assign(K + 1, NONE);
+	(holding ? hold : cash)[0] = 0;
+	advance(prices, n, K, unlimited, fee, cash.data(), hold.data());
+}
+
+// The states after a chunk from the states before it, by trying every split of the buys
+void apply(const ChunkEffect &effect, size_t K, std::vector<int64_t> &cash, std::vector<int64_t> &hold) {
+	std::vector<int64_t> newState[2] = {std::vector<int64_t>(K + 1, NONE), std::vector<int64_t>(K + 1, NONE)};
+	for (int s = 0; s < 2; s++) {
+		const std::vector<int64_t> &state = s == 0 ? cash : hold;
+		for (size_t d = 0; d <= K; d++) {
+			if (state[d] <= NONE / 2) continue;
+
+			for (int e = 0; e < 2; e++) {
+				const int64_t *gain = &effect.gain[(s * 2 + e) * (K + 1)];
+				for (size_t g = 0; d + g <= K; g++)
+					if (gain[g] > NONE / 2) newState[e][d + g] = std::max(newState[e][d + g], state[d] + gain[g]);
+			}
+		}
+	}
+	cash = std::move(newState[0]);
+	hold = std::move(newState[1]);
+}
+
+// Run task(i) for each i in [0, tasks) on at most `threads` threads
+template <typename Function>
+void parallelFor(size_t tasks, size_t threads, Function task) {
+	threads = std::max<size_t>(1, std::min(threads, tasks));
+
+	std::vector<std::thread> workers;
+	for (size_t t = 1; t < threads; t++) {
+		workers.emplace_back([&, t]() {
+			for (size_t i = t; i < tasks; i += threads) task(i);
+		});
+	}
+
+	for (size_t i = 0; i < tasks; i += threads) task(i);
+	for (auto &worker : workers) worker.join();
+}
+
+// Answer every series in prices[offsets[i], offsets[i + 1]) with at most k transactions (any number if k = 0), each
+// paying fee. Series are cut into chunks which are processed in parallel and combined in order. With one transaction
+// and no fee a chunk is a Summary, which is cheap, so long series are cut into fixed-size chunks. Otherwise every chunk
+// but the first of a series is run from both holding states, so a series is only cut into as many chunks as its share
+// of the threads.
+std::vector<int64_t> solve(const int32_t *prices, const uint64_t *offsets, size_t seriesCount, size_t k, int64_t fee, size_t threads) {
+	const size_t CHUNK_SIZE = 1 << 20;
+	bool single = k == 1 && fee == 0;
+
+	// (series, begin, end)
+	std::vector<std::tuple<size_t, size_t, size_t>> chunks;
+	for (size_t i = 0; i < seriesCount; i++) {
+		size_t n = offsets[i + 1] - offsets[i], count = (n + CHUNK_SIZE - 1) / CHUNK_SIZE;
+		if (!single) count = std::min(count, (n * threads + offsets[seriesCount] - 1) / std::max<uint64_t>(1, offsets[seriesCount]));
+
+		for (size_t c = 0; c < count; c++) chunks.emplace_back(i, offsets[i] + n * c / count, offsets[i] + n * (c + 1) / count);
+	}
+
+	std::vector<int64_t> answers(seriesCount);
+	if (single) {
+		std::vector<Summary> summaries(chunks.size());
+		parallelFor(chunks.size(), threads, [&](size_t i) {
+			auto [series, begin, end] = chunks[i];
+			summaries[i] = summarize(prices + begin, end - begin);
+		});
+
+		std::vector<Summary> total(seriesCount, EMPTY_SUMMARY);
+		for (size_t i = 0; i < chunks.size(); i++) total[std::get<0>(chunks[i])] = combine(total[std::get<0>(chunks[i])], summaries[i]);
+		for (size_t i = 0; i < seriesCount; i++) answers[i] = total[i].best;
+		return answers;
+	}
+
+	// With enough transactions every rise can be taken, so the number of buys isn't tracked
+	auto limit = [&](size_t series, bool &unlimited) -> size_t {
+		unlimited = k == 0 || k >= (offsets[series + 1] - offsets[series]) / 2;
+		return unlimited ? 0 : k;
+	};
+
+	// The states after the first chunk of each series, and the effects of the other chunks
+	std::vector<std::vector<int64_t>> firstCash(chunks.size()), firstHold(chunks.size());
+	std::vector<ChunkEffect> effects(chunks.size());
+	parallelFor(chunks.size(), threads, [&](size_t i) {
+		thread_local std::vector<int64_t> cash, hold;
+		auto [series, begin, end] = chunks[i];
+		bool unlimited;
+		size_t K = limit(series, unlimited);
+
+		if (begin == offsets[series]) {
+			runFrom(false, prices + begin, end - begin, K, unlimited, fee, firstCash[i], firstHold[i]);
+			return;
+		}
+
+		effects[i].gain.resize(4 * (K + 1));
+		for (int s = 0; s < 2; s++) {
+			runFrom(s == 1, prices + begin, end - begin, K, unlimited, fee, cash, hold);
+			std::copy(cash.begin(), cash.end(), effects[i].gain.begin() + (s * 2) * (K + 1));
+			std::copy(hold.begin(), hold.end(), effects[i].gain.begin() + (s * 2 + 1) * (K + 1));
 		}
+	});
+
+	// Chunks of a series are consecutive, the state of a series is carried in the slot of its first chunk
+	std::vector<size_t> firstChunk(seriesCount, SIZE_MAX);
+	for (size_t i = chunks.size(); i-- > 0; ) firstChunk[std::get<0>(chunks[i])] = i;
+
+	parallelFor(seriesCount, threads, [&](size_t series) {
+		size_t first = firstChunk[series];
+		if (first == SIZE_MAX) return;
+
+		bool unlimited;
+		size_t K = limit(series, unlimited);
+		std::vector<int64_t> &cash = firstCash[first], &hold = firstHold[first];
+		for (size_t i = first + 1; i < chunks.size() && std::get<0>(chunks[i]) == series; i++) apply(effects[i], K, cash, hold);
+
+		answers[series] = std::max<int64_t>(0, *std::max_element(cash.begin(), cash.end()));
+	});
+	return answers;
+}
+
+// A binary price file: the header, seriesCount + 1 offsets, then the prices of series i in [offsets[i], offsets[i + 1])
+struct PriceFileHeader {
+	static const uint64_t MAGIC = 0x534543495250; // "PRICES"
+
+	uint64_t magic, seriesCount;
+};
+
+void writePriceFile(const std::string &path, const std::vector<uint64_t> &offsets, const std::vector<int32_t> &prices) {
+	std::ofstream fout(path, std::ios::binary);
+	PriceFileHeader header = {PriceFileHeader::MAGIC, offsets.size() - 1};
+	fout.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	fout.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(uint64_t));
+	fout.write(reinterpret_cast<const char *>(prices.data()), prices.size() * sizeof(int32_t));
+	if (!fout) throw std::runtime_error("failed to write " + path);
+}
 
-		std::cout << ans << std::endl;
+// A price file mapped into memory, so series are read straight from the page cache
+class MappedPriceFile {
+	void *address = MAP_FAILED;
+	size_t length = 0;
+
+public:
+	const PriceFileHeader *header;
+	const uint64_t *offsets;
+	const int32_t *prices;
+
+	explicit MappedPriceFile(const std::string &path) {
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd < 0) throw std::runtime_error("failed to open " + path);
+
+		struct stat st;
+		if (fstat(fd, &st) == 0) {
+			length = st.st_size;
+			address = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+		}
+		close(fd);
+		if (address == MAP_FAILED) throw std::runtime_error("failed to map " + path);
+		madvise(address, length, MADV_SEQUENTIAL);
+
+		header = static_cast<const PriceFileHeader *>(address);
+		offsets = reinterpret_cast<const uint64_t *>(header + 1);
+
+		// The offsets must start at 0, never decrease and end at the number of prices left in the file
+		bool valid = length >= sizeof(PriceFileHeader) && header->magic == PriceFileHeader::MAGIC &&
+		             (length - sizeof(PriceFileHeader)) / sizeof(uint64_t) > header->seriesCount;
+		if (valid) {
+			size_t rest = length - sizeof(PriceFileHeader) - (header->seriesCount + 1) * sizeof(uint64_t);
+			valid = offsets[0] == 0 && rest % sizeof(int32_t) == 0 && offsets[header->seriesCount] == rest / sizeof(int32_t);
+			for (size_t i = 0; valid && i < header->seriesCount; i++) valid = offsets[i] <= offsets[i + 1];
+		}
+		if (valid) prices = reinterpret_cast<const int32_t *>(offsets + header->seriesCount + 1);
+
+		if (!valid) {
+			munmap(address, length);
+			throw std::runtime_error("invalid price file " + path);
+		}
+	}
+
+	MappedPriceFile(const MappedPriceFile &) = delete;
+	MappedPriceFile &operator=(const MappedPriceFile &) = delete;
+
+	~MappedPriceFile() {
+		munmap(address, length);
 	}
+};
+
+// Usage: MaxSingleSellProfit [--k K] [--fee F] [--threads N] [--binary FILE | --write-binary FILE]
+// Without --binary the series are read as text from stdin. K = 0 means any number of transactions.
+int main(int argc, char *argv[]) {
+	size_t k = 1, threads = std::max(1u, std::thread::hardware_concurrency());
+	int64_t fee = 0;
+	std::string binaryPath, writePath;
+	for (int i = 1; i < argc; i++) {
+		std::string option = argv[i], value = i + 1 < argc ? argv[++i] : "";
+
+		if (option == "--k" && !value.empty()) k = std::stoul(value);
+		else if (option == "--fee" && !value.empty()) fee = std::stoll(value);
+		else if (option == "--threads" && !value.empty()) threads = std::max<size_t>(1, std::stoul(value));
+		else if (option == "--binary" && !value.empty()) binaryPath = value;
+		else if (option == "--write-binary" && !value.empty()) writePath = value;
+		else {
+			std::cerr << "Usage: " << argv[0] << " [--k K] [--fee F] [--threads N] [--binary FILE | --write-binary FILE]" << std::endl;
+			return 1;
+		}
+	}
+
+	std::ios::sync_with_stdio(false);
+
+	std::vector<int64_t> answers;
+	if (!binaryPath.empty()) {
+		MappedPriceFile file(binaryPath);
+		answers = solve(file.prices, file.offsets, file.header->seriesCount, k, fee, threads);
+	} else {
+		std::vector<uint64_t> offsets(1, 0);
+		std::vector<int32_t> prices;
+		for (int n; std::cin >> n, n != 0; ) {
+			for (int i = 0; i < n; i++) {
+				int x;
+				std::cin >> x;
+				prices.push_back(x);
+			}
+			offsets.push_back(prices.size());
+		}
+
+		if (!writePath.empty()) {
+			writePriceFile(writePath, offsets, prices);
+			return 0;
+		}
+		answers = solve(prices.data(), offsets.data(), offsets.size() - 1, k, fee, threads);
+	}
+
+	for (int64_t answer : answers) std::cout << answer << '\n';
 }
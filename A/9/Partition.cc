@@ -1,39 +1,93 @@
 #include <iostream>
-#include <queue>
 #include <vector>
 #include <algorithm>
-#include <numeric>
-#include <cstdlib>
-#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <charconv>
+
+// Reads integers from a FILE through a large buffer
+class FastReader {
+	static const size_t BUFFER_SIZE = 1 << 16;
+
+	FILE *file;
+	char buffer[BUFFER_SIZE];
+	size_t size = 0, position = 0;
+
+	int getChar() {
+		if (position == size) {
+			size = fread(buffer, 1, BUFFER_SIZE, file);
+			position = 0;
+			if (size == 0) return EOF;
+		}
+		return buffer[position++];
+	}
 
-const double PI = acos(-1);
+public:
+	FastReader(FILE *file) : file(file) {}
 
-struct RealPoint {
-	int x, y;
+	template <typename T>
+	bool read(T &x) {
+		int c = getChar();
+		while (c != EOF && c != '-' && (c < '0' || c > '9')) c = getChar();
+		if (c == EOF) return false;
+
+		bool negative = c == '-';
+		if (negative) c = getChar();
+
+		for (x = 0; c >= '0' && c <= '9'; c = getChar()) x = x * 10 + (c - '0');
+		if (negative) x = -x;
+		return true;
+	}
+};
+
+// Collects output and writes it to a FILE in large blocks
+class BufferedWriter {
+	static const size_t BUFFER_SIZE = 1 << 16;
+
+	FILE *file;
+	char buffer[BUFFER_SIZE];
+	size_t size = 0;
+
+public:
+	BufferedWriter(FILE *file) : file(file) {}
+
+	~BufferedWriter() {
+		flush();
+	}
+
+	void flush() {
+		fwrite(buffer, 1, size, file);
+		size = 0;
+	}
+
+	void write(int x) {
+		if (size + 16 > BUFFER_SIZE) flush();
+		size = std::to_chars(buffer + size, buffer + BUFFER_SIZE, x).ptr - buffer;
+	}
+
+	void write(char c) {
+		if (size == BUFFER_SIZE) flush();
+		buffer[size++] = c;
+	}
 };
 
 struct Point {
-	int x, y, count;
-	double angle;
-	std::vector<RealPoint> realPoints;
+	int x, y;
 };
 
-inline bool isSameAngle(int x1, int y1, int x2, int y2) {
-	int g1 = std::gcd(x1, y1), g2 = std::gcd(x2, y2);
-	return x1 / g1 == x2 / g2 && y1 / g1 == y2 / g2;
+inline int64_t cross(const Point &a, const Point &b) {
+	return (int64_t)a.x * b.y - (int64_t)a.y * b.x;
 }
 
-inline bool isOnSameLine(int x1, int y1, int x2, int y2) {
-	return isSameAngle(abs(x1), abs(y1), abs(x2), abs(y2));
+// 0 for angles in [0, PI): above or on positive x-axis, 1 for [PI, 2PI)
+inline int half(const Point &p) {
+	return p.y > 0 || (p.y == 0 && p.x > 0) ? 0 : 1;
 }
 
-inline double angle(int x, int y) {
-	// angle from 0 to 2PI: from positive x-axis, anti-clockwise, to positive x-axis
-	double tmp = atan2(y, x);
-	if (tmp < 0) {
-		tmp += 2 * PI;
-	}
-	return tmp;
+// Anti-clockwise angle from positive x-axis, exactly
+inline bool angleLess(const Point &a, const Point &b) {
+	int ha = half(a), hb = half(b);
+	return ha != hb ? ha < hb : cross(a, b) > 0;
 }
 
 inline void transform(int &x, int &y, int w, int h, bool reverse = false) {
@@ -46,137 +100,135 @@ inline void transform(int &x, int &y, int w, int h, bool reverse = false) {
 	}
 }
 
-inline void printPoint(const Point *point, int w, int h, size_t &count) {
-	for (const RealPoint &realPoint : point->realPoints) {
-		if (count == 0) return;
+// Points with the same angle, points[begin, end) after sorting
+struct Group {
+	size_t begin, end;
 
-		int x = realPoint.x, y = realPoint.y;
-		transform(x, y, w, h, true);
-		std::cout << x << " " << y << std::endl;
+	size_t count() const {
+		return end - begin;
+	}
+};
 
-		count--;
+inline void printPoints(const Point *begin, const Point *end, int w, int h, size_t &count, BufferedWriter &writer) {
+	for (const Point *point = begin; point != end && count > 0; point++, count--) {
+		int x = point->x, y = point->y;
+		transform(x, y, w, h, true);
+		writer.write(x);
+		writer.write(' ');
+		writer.write(y);
+		writer.write('\n');
 	}
 }
 
 int main() {
-	for (int n, w, h; std::cin >> n >> w >> h, n != 0; ) {
-		std::vector<Point> points(n);
-		for (Point &point : points) {
-			std::cin >> point.x >> point.y;
+	FastReader reader(stdin);
+	BufferedWriter writer(stdout);
+
+	std::vector<Point> points, center;
+	std::vector<Group> groups;
+	for (int n, w, h; reader.read(n) && n != 0; ) {
+		reader.read(w);
+		reader.read(h);
+
+		// Points at the center are on every line, so they're kept aside and can go to either half
+		points.clear();
+		center.clear();
+		for (int i = 0; i < n; i++) {
+			Point point;
+			reader.read(point.x);
+			reader.read(point.y);
 			transform(point.x, point.y, w, h);
-			point.angle = angle(point.x, point.y);
+			(point.x == 0 && point.y == 0 ? center : points).push_back(point);
 		}
 
-		std::sort(points.begin(), points.end(), [](const Point &lhs, const Point &rhs) {
-			return lhs.angle < rhs.angle;
-		});
-
-		Point *equalRangeStart = nullptr;
-		for (Point &point : points) {
-			// Do NOT use .angle == .angle since there's floating error
-			if (equalRangeStart && isSameAngle(equalRangeStart->x, equalRangeStart->y, point.x, point.y)) {
-				equalRangeStart->count++;
-				point.count = 0;
-			} else {
-				equalRangeStart = &point;
-				point.count = 1;
+		std::sort(points.begin(), points.end(), angleLess);
+
+		// Groups with angles in [0, PI) come first, the first with an angle in [PI, 2PI) is split
+		groups.clear();
+		size_t split = 0;
+		for (size_t i = 0; i < points.size(); i++) {
+			if (i == 0 || half(points[i]) != half(points[i - 1]) || cross(points[i], points[i - 1]) != 0) {
+				if (!groups.empty()) groups.back().end = i;
+				groups.push_back({i, 0});
+				if (half(points[i]) == 0) split = groups.size();
 			}
-			equalRangeStart->realPoints.push_back({point.x, point.y});
 		}
+		if (!groups.empty()) groups.back().end = points.size();
+
+		auto direction = [&](size_t group) {
+			return points[groups[group].begin];
+		};
 
 		// Imagine we're starting with a line on x-axis but have a little offset
 		// so it doesn't cover any points on x-axis
-		// 
+		//
 		// We call the two side of the rotating line "above" and "below" according the
 		// initial state, above or below the x-axis, regardless of the real up/down direction
-		size_t aboveCount = 0, belowCount = 0;
-
-		// Starting with the horizontal line
-		std::queue<Point *> qAbove, qBelow;
-		for (Point &point : points) {
-			if (point.count == 0) continue;
-
-			// Above or on positive x-axis: qAvobe
-			// Below or on negative x-axis: qBelow
-			if (point.y > 0 || (point.y == 0 && point.x > 0)) {
-				qAbove.push(&point);
-				aboveCount += point.count;
-			} else {
-				qBelow.push(&point);
-				belowCount += point.count;
-			}
-		}
+		//
+		// The next groups to be passed are nextAbove and nextBelow. Groups [split, nextBelow) have been passed by
+		// the line from below and are above it now, except one on the line.
+		size_t aboveCount = 0, belowCount = 0, nextAbove = 0, nextBelow = split;
+		for (size_t i = 0; i < groups.size(); i++) (i < split ? aboveCount : belowCount) += groups[i].count();
 
 		// Along with the rotation of the line, the points on the line which are previously
 		// above the line will go below the line, otherwise go above the line
-		Point *onLineFromAbove = nullptr, *onLineFromBelow = nullptr;
-
-		// The angle of each of two sides of the line and positive x-axis, up and down still
-		// only describes the initial state
-		double currentAngleUp = angle(1, 0), currentAngleDown = angle(-1, 0);
-
-		// The points passed by the dividing line
-		std::vector<Point *> passedAbove, passedBelow;
-	
-		while (!qAbove.empty() || !qBelow.empty()) {
-			if (onLineFromBelow) {
-				aboveCount += onLineFromBelow->count;
-				passedAbove.push_back(onLineFromBelow);
-			}
-
-			if (onLineFromAbove) {
-				belowCount += onLineFromAbove->count;
-				passedBelow.push_back(onLineFromAbove);
-			}
-
-			onLineFromAbove = onLineFromBelow = nullptr;
-
-			Point *nearestAbove = qAbove.empty() ? nullptr : qAbove.front(),
-				  *nearestBelow = qBelow.empty() ? nullptr : qBelow.front();
-
-			// Choose a smaller angle increment from two sides of the line to rotate
-			Point *nearestAnglePoint = (!nearestBelow || (nearestAbove && nearestAbove->angle - currentAngleUp < nearestBelow->angle - currentAngleDown))
-									 ? nearestAbove
-									 : nearestBelow;
+		const size_t NONE = SIZE_MAX;
+		size_t onLineFromAbove = NONE, onLineFromBelow = NONE;
+
+		while (true) {
+			if (onLineFromBelow != NONE) aboveCount += groups[onLineFromBelow].count();
+			if (onLineFromAbove != NONE) belowCount += groups[onLineFromAbove].count();
+			onLineFromAbove = onLineFromBelow = NONE;
+
+			// There's nothing to pass if all points are at the center
+			if (nextAbove < split || nextBelow < groups.size()) {
+				size_t nearestAbove = nextAbove < split ? nextAbove : NONE,
+				       nearestBelow = nextBelow < groups.size() ? nextBelow : NONE;
+
+				// Choose a smaller angle increment from two sides of the line to rotate, a point below is compared
+				// by its opposite direction
+				Point nearest;
+				if (nearestBelow == NONE) nearest = direction(nearestAbove);
+				else {
+					Point opposite = {-direction(nearestBelow).x, -direction(nearestBelow).y};
+					nearest = nearestAbove != NONE && cross(direction(nearestAbove), opposite) > 0 ? direction(nearestAbove) : opposite;
+				}
 
-			// Check if nearest point above / below is on the rotated line
-			if (nearestAbove && isOnSameLine(nearestAbove->x, nearestAbove->y, nearestAnglePoint->x, nearestAnglePoint->y)) {
-				onLineFromAbove = nearestAbove;
-				aboveCount -= nearestAbove->count;
-				qAbove.pop();
-			}
+				// Check if nearest point above / below is on the rotated line
+				if (nearestAbove != NONE && cross(direction(nearestAbove), nearest) == 0) {
+					onLineFromAbove = nearestAbove;
+					aboveCount -= groups[nearestAbove].count();
+					nextAbove++;
+				}
 
-			if (nearestBelow && isOnSameLine(nearestBelow->x, nearestBelow->y, nearestAnglePoint->x, nearestAnglePoint->y)) {
-				onLineFromBelow = nearestBelow;
-				belowCount -= nearestBelow->count;
-				qBelow.pop();
+				if (nearestBelow != NONE && cross(direction(nearestBelow), nearest) == 0) {
+					onLineFromBelow = nearestBelow;
+					belowCount -= groups[nearestBelow].count();
+					nextBelow++;
+				}
 			}
 
 			// Check if the current position of the dividing line is a valid solution
 			// since we can choose which half to assign each point that lies exactly on the dividing
 			// line, points "above" and "below" only needs to be less than or equal to half of number of points
-			if (aboveCount <= n / 2 && belowCount <= n / 2) {
+			if (aboveCount <= size_t(n / 2) && belowCount <= size_t(n / 2)) {
 				// Print the solution (points "above" the line only)
 				// It's not required, but we can print with the ascending angle order
 				size_t count = n / 2, countAbove = aboveCount, countNotAbove = count - aboveCount;
+				auto print = [&](size_t group, size_t &count) {
+					printPoints(&points[groups[group].begin], &points[0] + groups[group].end, w, h, count, writer);
+				};
 
-				if (onLineFromAbove) printPoint(onLineFromAbove, w, h, countNotAbove);
-
-				while (!qAbove.empty() && countAbove > 0) {
-					Point *point = qAbove.front();
-					qAbove.pop();
-					printPoint(point, w, h, countAbove);
-				}
-
-				for (Point *point : passedAbove) {
-					printPoint(point, w, h, countAbove);
-					if (countAbove == 0) break;
-				}
-
-				if (onLineFromBelow) printPoint(onLineFromBelow, w, h, countNotAbove);
+				if (onLineFromAbove != NONE) print(onLineFromAbove, countNotAbove);
+				for (size_t i = nextAbove; i < split && countAbove > 0; i++) print(i, countAbove);
+				for (size_t i = split; i < nextBelow - (onLineFromBelow != NONE) && countAbove > 0; i++) print(i, countAbove);
+				if (onLineFromBelow != NONE) print(onLineFromBelow, countNotAbove);
+				printPoints(center.data(), center.data() + center.size(), w, h, countNotAbove, writer);
 
 				break;
 			}
+
+			if (nextAbove == split && nextBelow == groups.size() && onLineFromAbove == NONE && onLineFromBelow == NONE) break;
 		}
 	}
 }